@@ -0,0 +1,82 @@
+#ifndef AUDIOFILTERS_HPP
+#define AUDIOFILTERS_HPP
+#include <cmath>
+#include <numbers>
+
+/* Per sample filters of the sound chain. State only, nothing allocates, so
+ * they can run in the audio callback. */
+
+/* One pole high pass removing the DC offset */
+class DcBlocker {
+public:
+  void setCutoff(float cutoff, float sampleRate) {
+    r = std::exp(-2 * std::numbers::pi_v<float> * cutoff / sampleRate);
+  }
+
+  float process(float x) {
+    const float y = x - x1 + r * y1;
+    x1 = x;
+    y1 = y;
+    return y;
+  }
+
+private:
+  float r = 0.995f;
+  float x1 = 0.f;
+  float y1 = 0.f;
+};
+
+/* Second order section, transposed direct form II. Coefficients from the
+ * RBJ audio EQ cookbook. */
+class Biquad {
+public:
+  void setLowPass(float cutoff, float q, float sampleRate) {
+    const float w = 2 * std::numbers::pi_v<float> * cutoff / sampleRate;
+    const float alpha = std::sin(w) / (2 * q);
+    const float c = std::cos(w);
+    set((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+  }
+
+  /* Resonance of the exhaust pipe, gain in dB at the centre */
+  void setPeak(float centre, float q, float gainDb, float sampleRate) {
+    const float a = std::pow(10.f, gainDb / 40);
+    const float w = 2 * std::numbers::pi_v<float> * centre / sampleRate;
+    const float alpha = std::sin(w) / (2 * q);
+    const float c = std::cos(w);
+    set(1 + alpha * a, -2 * c, 1 - alpha * a, 1 + alpha / a, -2 * c,
+        1 - alpha / a);
+  }
+
+  float process(float x) {
+    const float y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return y;
+  }
+
+private:
+  void set(float nb0, float nb1, float nb2, float na0, float na1, float na2) {
+    b0 = nb0 / na0;
+    b1 = nb1 / na0;
+    b2 = nb2 / na0;
+    a1 = na1 / na0;
+    a2 = na2 / na0;
+  }
+
+  float b0 = 1.f, b1 = 0.f, b2 = 0.f;
+  float a1 = 0.f, a2 = 0.f;
+  float z1 = 0.f, z2 = 0.f;
+};
+
+/* Rational tanh approximation, bounded to [-1, 1] */
+inline float softClip(float x) {
+  if (x <= -3.f) {
+    return -1.f;
+  }
+  if (x >= 3.f) {
+    return 1.f;
+  }
+  return x * (27 + x * x) / (27 + 9 * x * x);
+}
+
+#endif
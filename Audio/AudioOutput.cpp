@@ -0,0 +1,43 @@
+#include "AudioOutput.hpp"
+#include <cstdio>
+
+AudioOutput::~AudioOutput() { close(); }
+
+bool AudioOutput::open(int bufferSize) {
+  close();
+
+  SDL_AudioSpec wanted = {};
+  wanted.freq = 48000;
+  wanted.format = AUDIO_F32SYS;
+  wanted.channels = 1;
+  wanted.samples = bufferSize;
+  wanted.callback = callback;
+  wanted.userdata = this;
+
+  SDL_AudioSpec obtained;
+  device = SDL_OpenAudioDevice(nullptr, 0, &wanted, &obtained,
+                               SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+  if (device == 0) {
+    fprintf(stderr, "Cannot open an audio device: %s\n", SDL_GetError());
+    return false;
+  }
+
+  /* Devices open paused, the callback cannot run before the sound exists */
+  sound = std::make_unique<EngineSound>(obtained.freq, obtained.samples);
+  SDL_PauseAudioDevice(device, 0);
+  return true;
+}
+
+void AudioOutput::close() {
+  if (device != 0) {
+    SDL_CloseAudioDevice(device);
+    device = 0;
+  }
+  sound.reset();
+}
+
+void AudioOutput::callback(void *userdata, Uint8 *stream, int len) {
+  auto *output = static_cast<AudioOutput *>(userdata);
+  output->sound->render(reinterpret_cast<float *>(stream),
+                        len / static_cast<int>(sizeof(float)));
+}
@@ -0,0 +1,30 @@
+#ifndef AUDIOOUTPUT_HPP
+#define AUDIOOUTPUT_HPP
+#include "EngineSound.hpp"
+#include <SDL2/SDL.h>
+#include <memory>
+
+/* Plays an EngineSound on an SDL audio device. The driver follows
+ * SDL_AUDIODRIVER, so headless machines can use "dummy", or "disk" to write
+ * the stream to SDL_DISKAUDIOFILE. The audio subsystem must be initialised. */
+class AudioOutput {
+public:
+  ~AudioOutput();
+
+  /* Opens the default device with a callback of bufferSize samples. The
+   * sound is created for the rate the device settles on. 128 samples at
+   * 48 kHz keep the queue and device near 10 ms. */
+  bool open(int bufferSize = 128);
+  void close();
+
+  /* Null until open() succeeds */
+  EngineSound *getSound() { return sound.get(); }
+
+private:
+  static void callback(void *userdata, Uint8 *stream, int len);
+
+  SDL_AudioDeviceID device = 0;
+  std::unique_ptr<EngineSound> sound;
+};
+
+#endif
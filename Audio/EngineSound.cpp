@@ -0,0 +1,120 @@
+#include "EngineSound.hpp"
+#include <algorithm>
+
+/* Fill control: the minimum over a window of output time is compared with
+ * the target, and the error spread over the next window */
+constexpr float CONTROL_WINDOW = 0.1f; /* [s], several simulation ticks */
+constexpr float MAX_RATIO_CHANGE = 0.05f;
+constexpr float MAX_EXCESS = 0.05f; /* Dropped at once beyond [s] */
+
+EngineSound::EngineSound(float deviceRate, int deviceBuffer,
+                         float targetDelay)
+    : deviceRate{deviceRate}, deviceDelay{deviceBuffer / deviceRate},
+      targetDelay{targetDelay} {
+  dcBlocker.setCutoff(20.f, deviceRate);
+  pipe.setPeak(120.f, 2.f, 6.f, deviceRate);
+  configureFilters(deviceRate);
+}
+
+void EngineSound::push(const Piston &piston, float deltaT) {
+  /* A pulsating source radiates its flow rate derivative */
+  const float outflow = -piston.exhaustFlow / deltaT;
+  const float pulse = (outflow - previousOutflow) / deltaT;
+  previousOutflow = outflow;
+  const float pressure = PAToATM(piston.gas.getP()) - 1;
+
+  if (!ring.push({exhaustGain * pulse + pressureGain * pressure, deltaT})) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void EngineSound::configureFilters(float rate) {
+  /* Steps are held for their duration, the staircase has images above half
+   * the step rate */
+  filterRate = rate;
+  antiImage.setLowPass(0.45f * rate, 0.7071f, deviceRate);
+}
+
+void EngineSound::render(float *out, int frames) {
+  /* Seconds of sound waiting, estimated from the current step size */
+  const float queued = ring.size() * current.dt + remaining;
+
+  /* At start and after an underrun, wait for a full callback plus margin */
+  if (!started) {
+    AudioFrame next;
+    if (current.dt == 0.f && ring.pop(next)) {
+      current = next;
+      remaining = next.dt;
+    }
+    if (current.dt == 0.f || queued < deviceDelay + targetDelay) {
+      std::fill(out, out + frames, 0.f);
+      return;
+    }
+    started = true;
+  }
+
+  minQueued = std::min(minQueued, queued);
+  windowTime += frames / deviceRate;
+
+  if (windowTime >= CONTROL_WINDOW) {
+    /* A callback must find at least its own length queued */
+    const float excess = minQueued - deviceDelay - targetDelay;
+    if (excess > MAX_EXCESS && current.dt > 0) {
+      /* After a stall: catch up rather than lag behind for good */
+      AudioFrame frame;
+      for (float skipped = 0.f; skipped < excess && ring.pop(frame);) {
+        skipped += frame.dt;
+      }
+      ratio = 1.f;
+    } else {
+      ratio = 1.f + std::clamp(excess / CONTROL_WINDOW, -MAX_RATIO_CHANGE,
+                               MAX_RATIO_CHANGE);
+    }
+    latency.store(std::max(minQueued, 0.f) + deviceDelay,
+                  std::memory_order_relaxed);
+    minQueued = 1e9f;
+    windowTime = 0.f;
+  }
+
+  if (current.dt > 0) {
+    const float stepRate = std::min(1 / current.dt, deviceRate);
+    if (std::fabs(stepRate - filterRate) > 0.01f * filterRate) {
+      configureFilters(stepRate);
+    }
+  }
+
+  const float step = ratio / deviceRate; /* Input time per sample [s] */
+  const float gain = volume.load(std::memory_order_relaxed);
+  bool underrun = false;
+
+  for (int i = 0; i < frames; ++i) {
+    /* Average of the held step values over the sample */
+    float need = step;
+    float area = 0.f;
+    while (need > 0.f) {
+      if (remaining <= 0.f) {
+        if (!ring.pop(current)) {
+          /* Hold the last value, the DC blocker fades it out */
+          area += current.value * need;
+          underrun = true;
+          break;
+        }
+        remaining = current.dt;
+      }
+      const float take = std::min(need, remaining);
+      area += current.value * take;
+      remaining -= take;
+      need -= take;
+    }
+
+    float y = dcBlocker.process(area / step);
+    y = antiImage.process(y);
+    y = pipe.process(y);
+    out[i] = softClip(gain * y);
+  }
+
+  if (underrun) {
+    started = false;
+    underruns.fetch_add(1, std::memory_order_relaxed);
+  }
+}
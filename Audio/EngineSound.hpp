@@ -0,0 +1,87 @@
+#ifndef ENGINESOUND_HPP
+#define ENGINESOUND_HPP
+#include "AudioFilters.hpp"
+#include "Piston.hpp"
+#include "SpscQueue.hpp"
+#include <atomic>
+#include <cstdint>
+
+/* Sound of one simulation step, held for its duration */
+struct AudioFrame {
+  float value;
+  float dt; /* [s] */
+};
+
+/* Turns the exhaust pulses and the chamber pressure into sound. The
+ * simulation thread pushes one frame per step into a lock-free ring. The
+ * audio callback averages the frames over every output sample, which
+ * resamples any step rate, fixed or adaptive, to the device rate and band
+ * limits it when steps are shorter than samples. It then runs the filter
+ * chain. The callback neither allocates nor locks.
+ *
+ * The simulation produces a tick worth of frames at once, so the ring fill
+ * saws between bursts. Its minimum is what a fresh frame waits behind: the
+ * consumer speeds up or slows down by a few percent to hold that minimum at
+ * one callback buffer plus targetDelay, and drops the excess after a
+ * stall. */
+class EngineSound {
+public:
+  static constexpr size_t RING_SIZE = 1 << 15;
+
+  /* deviceBuffer is the callback size [samples] */
+  EngineSound(float deviceRate, int deviceBuffer, float targetDelay = 0.004f);
+
+  /* Simulation thread, after every step */
+  void push(const Piston &piston, float deltaT);
+
+  /* Audio thread, mono */
+  void render(float *out, int frames);
+
+  /* Any thread */
+  float getLatency() const { return latency.load(std::memory_order_relaxed); }
+  uint64_t getUnderruns() const {
+    return underruns.load(std::memory_order_relaxed);
+  }
+  uint64_t getDropped() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+  std::atomic<float> volume{0.5f};
+
+  /* Mix, set before streaming */
+  float exhaustGain = 5e-5f;  /* Per unit of outflow acceleration */
+  float pressureGain = 3e-3f; /* Per atm above ambient */
+
+private:
+  /* rate is the step rate, at most the device rate */
+  void configureFilters(float rate);
+
+  const float deviceRate;  /* [Hz] */
+  const float deviceDelay; /* Of one callback buffer [s] */
+  const float targetDelay; /* Margin over one callback buffer [s] */
+
+  SpscQueue<AudioFrame, RING_SIZE> ring;
+
+  /* Simulation thread */
+  float previousOutflow = 0.f;
+
+  /* Audio thread */
+  bool started = false;
+  AudioFrame current = {0.f, 0.f};
+  float remaining = 0.f; /* Of the current frame [s] */
+  float ratio = 1.f;     /* Input seconds per output second */
+  float minQueued = 1e9f;
+  float windowTime = 0.f;
+  float filterRate = 0.f; /* Rate the filters are set for [Hz] */
+  DcBlocker dcBlocker;
+  Biquad antiImage;
+  Biquad pipe;
+
+  std::atomic<float> latency{0.f};
+  std::atomic<uint64_t> underruns{0};
+  std::atomic<uint64_t> dropped{0};
+
+  static_assert(std::atomic<float>::is_always_lock_free);
+  static_assert(std::atomic<uint64_t>::is_always_lock_free);
+};
+
+#endif
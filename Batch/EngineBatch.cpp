@@ -0,0 +1,233 @@
+#include "EngineBatch.hpp"
+#include "SimdVec.hpp"
+#include <numbers>
+
+constexpr size_t MAX_WIDTH = 16; /* AVX-512 */
+
+/* Gas state of one vector of engines */
+struct GasLanes {
+  VecF p;
+  VecF V;
+  VecF nR;
+  VecF T;
+  VecF ox;
+};
+
+/* Batched counterparts of the IdealGas/Gas processes */
+
+static inline void AdiabaticCompress(GasLanes &g, VecF vprime, VecF dt) {
+  const VecF v = fma(vprime, dt, g.V);
+  g.p = g.p * vpow(v / g.V, splat(-1.4f));
+  g.V = v;
+  g.T = g.p * g.V / g.nR;
+}
+
+static inline VecF SimpleFlow(GasLanes &g, VecF kFlow, VecF extP, VecF extT,
+                              VecF extOx, VecF dt) {
+  const VecF a = g.T / g.V;
+  const VecF p0 = g.p;
+  const VecF nr0 = g.nR;
+  const VecF nrPrime = kFlow * (extP - p0);
+  const VecF dnR = nrPrime * dt;
+
+  g.p = fma(p0 - extP, vexp(splat(0.f) - a * kFlow * dt), extP);
+  g.nR = nr0 + dnR;
+
+  /* Weighted average of entering and internal fluid */
+  const MaskF entering = nrPrime > splat(0.f);
+  const VecF ox = fma(dnR, extOx, nr0 * g.ox) / g.nR;
+  const VecF adjT = g.p * g.V / g.nR;
+  const VecF t = fma(dnR, extT, nr0 * adjT) / g.nR;
+  g.ox = select(entering, ox, g.ox);
+  g.T = select(entering, t, g.T);
+
+  return dnR;
+}
+
+static inline void HeatExchange(GasLanes &g, VecF kTherm, VecF extT, VecF dt) {
+  const VecF alpha = splat(5.f / 2.f);
+  const VecF y1 = g.T - extT;
+  const VecF cr = extT * g.nR / g.V;
+  const VecF y2 = g.p - cr;
+  const VecF expo = vexp(kTherm * dt / (alpha * g.nR));
+
+  g.T = fma(y1, expo, extT);
+  g.p = (splat(1.f) - expo) * g.nR * y1 / g.V + y2 + cr;
+}
+
+static inline void InjectHeat(GasLanes &g, MaskF active, VecF kx, VecF dt) {
+  const VecF alpha = splat(5.f / 2.f);
+  const VecF qprime = splat(10000.f) * kx * g.nR * g.ox / dt;
+
+  g.T = select(active, g.T + dt * qprime / (alpha * g.nR), g.T);
+  g.p = select(active, g.p + dt * qprime / (alpha * g.V), g.p);
+  g.ox = select(active, g.ox * (splat(1.f) - kx), g.ox);
+}
+
+/* Angle wrapped to [0, 360) */
+static inline VecF wrapAngle(VecF angle) {
+  return angle - splat(360.f) * floor(angle * splat(1.f / 360.f));
+}
+
+static inline MaskF isSet(const float *flag) {
+  return load(flag) > splat(0.5f);
+}
+
+static inline VecF flag(MaskF m) { return select(m, splat(1.f), splat(0.f)); }
+
+EngineBatch::EngineBatch(size_t count, CylinderGeometry geometry)
+    : geometry{geometry}, count{count},
+      padded{(count + MAX_WIDTH - 1) / MAX_WIDTH * MAX_WIDTH} {
+  for (Column *c :
+       {&headAngle, &currentAngle, &pistonPosition, &omega, &pressure, &volume,
+        &nR, &temperature, &ox, &intakeValve, &exhaustValve,
+        &combustionInProgress, &intakeFlow, &exhaustFlow, &torque, &cycleEnd,
+        &throttle, &minThrottle, &externalTorque, &setSpeed,
+        &combustionAdvance, &kexpl, &thermalK, &intakeCoef, &exhaustCoef,
+        &ignitionOn, &dynamicsIsActive}) {
+    c->resize(padded);
+  }
+
+  /* Padding lanes are stepped too, so they must hold a sane state */
+  const Piston reference(geometry);
+  for (size_t i = 0; i < padded; ++i) {
+    assign(i, reference);
+  }
+}
+
+void EngineBatch::assign(size_t i, const Piston &piston) {
+  headAngle[i] = piston.headAngle;
+  currentAngle[i] = piston.currentAngle;
+  pistonPosition[i] = piston.getPistonPosition();
+  omega[i] = piston.omega;
+
+  pressure[i] = piston.gas.getP();
+  volume[i] = piston.gas.getV();
+  nR[i] = piston.gas.getnR();
+  temperature[i] = piston.gas.getT();
+  ox[i] = piston.gas.getOx();
+
+  intakeValve[i] = piston.intakeValve;
+  exhaustValve[i] = piston.exhaustValve;
+  combustionInProgress[i] = piston.combustionInProgress;
+
+  intakeFlow[i] = 0.f;
+  exhaustFlow[i] = 0.f;
+  torque[i] = 0.f;
+  cycleEnd[i] = 0.f;
+
+  throttle[i] = piston.throttle;
+  minThrottle[i] = piston.minThrottle;
+  externalTorque[i] = piston.externalTorque;
+  setSpeed[i] = piston.omega;
+  combustionAdvance[i] = piston.combustionAdvance;
+  kexpl[i] = piston.kexpl;
+  thermalK[i] = piston.thermalK;
+  intakeCoef[i] = piston.intakeCoef;
+  exhaustCoef[i] = piston.exhaustCoef;
+  ignitionOn[i] = piston.ignitionOn;
+  dynamicsIsActive[i] = piston.dynamicsIsActive;
+}
+
+void EngineBatch::step(float deltaT) {
+  const float halfStroke = geometry.stroke / 2;
+  const VecF dt = splat(deltaT);
+  const VecF surface =
+      splat(geometry.bore * geometry.bore * std::numbers::pi_v<float> * 0.25f);
+  const VecF rod = splat(geometry.rod);
+  const VecF rodRatio = splat(geometry.stroke / (2 * geometry.rod));
+  const VecF leverArm = splat(halfStroke);
+  const VecF inertia = splat(geometry.momentOfInertia);
+  const VecF ambientP = splat(DEFAULT_AMBIENT_PRESSURE);
+  const VecF ambientT = splat(DEFAULT_AMBIENT_TEMPERATURE);
+  const VecF zero = splat(0.f);
+  const VecF one = splat(1.f);
+  const VecF burnSteps = splat(deltaT / COMBUSTION_REFERENCE_STEP);
+  const bool referenceStep = deltaT == COMBUSTION_REFERENCE_STEP;
+
+  /* Crank torque for a given pressure, crank angle and rod angle cosines */
+  const auto crankTorque = [&](VecF p, VecF cosAngle, VecF cosTheta, VecF w) {
+    const VecF absTorque = surface * (p - ambientP) * cosTheta * leverArm;
+    const VecF friction = w * splat(-0.05f);
+    return select(cosAngle < zero, absTorque, zero - absTorque) + friction;
+  };
+
+  for (size_t i = 0; i < padded; i += VecF::width) {
+    GasLanes g = {load(&pressure[i]), load(&volume[i]), load(&nR[i]),
+                  load(&temperature[i]), load(&ox[i])};
+    VecF w = load(&omega[i]);
+
+    /* Kinematics, head crank rotates at half the speed */
+    const VecF previousHead = load(&headAngle[i]);
+    const VecF head = wrapAngle(fma(
+        w, splat(static_cast<float>(90.0 / std::numbers::pi) * deltaT),
+        previousHead));
+    const VecF current = wrapAngle(fma(head, splat(2.f), splat(90.f)));
+
+    VecF sinAngle, cosAngle;
+    vsincosDeg(current, sinAngle, cosAngle);
+    const VecF k = rodRatio * cosAngle;
+    const VecF cosTheta = sqrt(one - k * k);
+
+    /* The chamber volume changes by the piston surface times its travel */
+    const VecF position =
+        fma(splat(-halfStroke), sinAngle, zero - rod * cosTheta);
+    const VecF vprime = surface * (position - load(&pistonPosition[i])) / dt;
+
+    /* Crankshaft dynamics */
+    const VecF accel = (crankTorque(g.p, cosAngle, cosTheta, w) +
+                        load(&externalTorque[i])) /
+                       inertia;
+    w = select(isSet(&dynamicsIsActive[i]), fma(dt, accel, w),
+               load(&setSpeed[i]));
+
+    /* Spark plug and cycle end */
+    const VecF sparkAngle = load(&combustionAdvance[i]) + splat(180.f);
+    const MaskF spark =
+        maskAndNot(maskAnd(isSet(&ignitionOn[i]), previousHead < sparkAngle),
+                   head < sparkAngle);
+    const MaskF cycle = previousHead > head;
+    const MaskF combustion =
+        maskAndNot(maskOr(isSet(&combustionInProgress[i]), spark), cycle);
+
+    /* Valve profiles */
+    const VecF xInt = (wrapAngle(head - splat(180.f)) - splat(225.f)) *
+                      splat(1.f / 30.f);
+    const VecF xExh = (wrapAngle(head + splat(180.f)) - splat(135.f)) *
+                      splat(1.f / 20.f);
+    const VecF intake = vexp(zero - xInt * xInt);
+    const VecF exhaust = vexp(zero - xExh * xExh);
+
+    /* Thermodynamics */
+    const VecF minThr = load(&minThrottle[i]);
+    const VecF thr = fma(one - minThr, load(&throttle[i]), minThr);
+
+    AdiabaticCompress(g, vprime, dt);
+    const VecF inFlow = SimpleFlow(g, thr * load(&intakeCoef[i]) * intake,
+                                   ambientP, ambientT, one, dt);
+    const VecF outFlow = SimpleFlow(g, load(&exhaustCoef[i]) * exhaust,
+                                    ambientP, ambientT, zero, dt);
+    HeatExchange(g, load(&thermalK[i]), ambientT, dt);
+    const VecF kx = referenceStep
+                        ? load(&kexpl[i])
+                        : one - vpow(one - load(&kexpl[i]), burnSteps);
+    InjectHeat(g, combustion, kx, dt);
+
+    store(&headAngle[i], head);
+    store(&currentAngle[i], current);
+    store(&pistonPosition[i], position);
+    store(&omega[i], w);
+    store(&pressure[i], g.p);
+    store(&volume[i], g.V);
+    store(&nR[i], g.nR);
+    store(&temperature[i], g.T);
+    store(&ox[i], g.ox);
+    store(&intakeValve[i], intake);
+    store(&exhaustValve[i], exhaust);
+    store(&combustionInProgress[i], flag(combustion));
+    store(&intakeFlow[i], inFlow);
+    store(&exhaustFlow[i], outFlow);
+    store(&torque[i], crankTorque(g.p, cosAngle, cosTheta, w));
+    store(&cycleEnd[i], flag(cycle));
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef ENGINEBATCH_HPP
+#define ENGINEBATCH_HPP
+#include "Piston.hpp"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+template <typename T, size_t Align = 64> struct AlignedAllocator {
+  using value_type = T;
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U> AlignedAllocator(const AlignedAllocator<U, Align> &) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{Align}));
+  }
+  void deallocate(T *p, size_t) {
+    ::operator delete(p, std::align_val_t{Align});
+  }
+  bool operator==(const AlignedAllocator &) const { return true; }
+};
+
+/* N single-cylinder engines sharing one geometry, stored as structure of
+ * arrays and stepped in lockstep by vectorized kernels. The physics is the
+ * one of Piston::updatePosition; boolean fields are stored as 0/1 floats. */
+class EngineBatch {
+public:
+  using Column = std::vector<float, AlignedAllocator<float>>;
+
+  EngineBatch(size_t count, CylinderGeometry geometry);
+
+  size_t size() const { return count; }
+
+  /* Copy the state and the inputs of a single engine into slot i */
+  void assign(size_t i, const Piston &piston);
+  void step(float deltaT);
+
+  CylinderGeometry geometry;
+
+  /* Kinematics */
+  Column headAngle;
+  Column currentAngle;
+  Column pistonPosition;
+  Column omega;
+
+  /* Gas */
+  Column pressure;
+  Column volume;
+  Column nR;
+  Column temperature;
+  Column ox;
+
+  /* Valves and combustion */
+  Column intakeValve;
+  Column exhaustValve;
+  Column combustionInProgress;
+
+  /* Outputs of the last step */
+  Column intakeFlow;
+  Column exhaustFlow;
+  Column torque;
+  Column cycleEnd;
+
+  /* Inputs */
+  Column throttle;
+  Column minThrottle;
+  Column externalTorque;
+  Column setSpeed;
+  Column combustionAdvance;
+  Column kexpl;
+  Column thermalK;
+  Column intakeCoef;
+  Column exhaustCoef;
+  Column ignitionOn;
+  Column dynamicsIsActive;
+
+private:
+  size_t count;
+  size_t padded; /* Column length, a multiple of the widest vector */
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef SIMDVEC_HPP
+#define SIMDVEC_HPP
+#include "LaneMath.hpp"
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+/* Thin wrapper over the widest float vector available at compile time.
+ * The batch kernels are written against these few operations only, so the
+ * same source compiles to AVX-512, AVX2 or plain scalar code. The math
+ * functions below are shared by all three, which keeps results identical
+ * whatever the instruction set. */
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+/* GCC 12 AVX-512 intrinsics use self-initialized placeholders (PR 105593) */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+struct VecF {
+  static constexpr int width = 16;
+  __m512 v;
+};
+using MaskF = __mmask16;
+
+inline VecF load(const float *p) { return {_mm512_load_ps(p)}; }
+inline void store(float *p, VecF a) { _mm512_store_ps(p, a.v); }
+inline VecF splat(float x) { return {_mm512_set1_ps(x)}; }
+inline VecF splat(VecF, float x) { return splat(x); }
+
+inline VecF operator+(VecF a, VecF b) { return {_mm512_add_ps(a.v, b.v)}; }
+inline VecF operator-(VecF a, VecF b) { return {_mm512_sub_ps(a.v, b.v)}; }
+inline VecF operator*(VecF a, VecF b) { return {_mm512_mul_ps(a.v, b.v)}; }
+inline VecF operator/(VecF a, VecF b) { return {_mm512_div_ps(a.v, b.v)}; }
+inline VecF fma(VecF a, VecF b, VecF c) {
+  return {_mm512_fmadd_ps(a.v, b.v, c.v)};
+}
+inline VecF min(VecF a, VecF b) { return {_mm512_min_ps(a.v, b.v)}; }
+inline VecF max(VecF a, VecF b) { return {_mm512_max_ps(a.v, b.v)}; }
+inline VecF sqrt(VecF a) { return {_mm512_sqrt_ps(a.v)}; }
+inline VecF floor(VecF a) {
+  return {_mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)};
+}
+inline VecF round(VecF a) {
+  return {
+      _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline MaskF operator<(VecF a, VecF b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ);
+}
+inline MaskF operator>(VecF a, VecF b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ);
+}
+inline MaskF maskAnd(MaskF a, MaskF b) { return a & b; }
+inline MaskF maskOr(MaskF a, MaskF b) { return a | b; }
+inline MaskF maskAndNot(MaskF a, MaskF b) { return a & ~b; }
+inline VecF select(MaskF m, VecF a, VecF b) {
+  return {_mm512_mask_blend_ps(m, b.v, a.v)};
+}
+
+/* 2^n for integral n */
+inline VecF pow2n(VecF n) {
+  const __m512i i = _mm512_add_epi32(_mm512_cvtps_epi32(n.v),
+                                     _mm512_set1_epi32(127));
+  return {_mm512_castsi512_ps(_mm512_slli_epi32(i, 23))};
+}
+
+/* x = m * 2^e with m in [0.5, 1), returns e */
+inline VecF splitExponent(VecF x, VecF &m) {
+  const __m512i i = _mm512_castps_si512(x.v);
+  const __m512i e =
+      _mm512_sub_epi32(_mm512_srli_epi32(i, 23), _mm512_set1_epi32(126));
+  m = {_mm512_castsi512_ps(
+      _mm512_or_si512(_mm512_and_si512(i, _mm512_set1_epi32(0x007fffff)),
+                      _mm512_set1_epi32(0x3f000000)))};
+  return {_mm512_cvtepi32_ps(e)};
+}
+
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+
+struct VecF {
+  static constexpr int width = 8;
+  __m256 v;
+};
+using MaskF = __m256;
+
+inline VecF load(const float *p) { return {_mm256_load_ps(p)}; }
+inline void store(float *p, VecF a) { _mm256_store_ps(p, a.v); }
+inline VecF splat(float x) { return {_mm256_set1_ps(x)}; }
+inline VecF splat(VecF, float x) { return splat(x); }
+
+inline VecF operator+(VecF a, VecF b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline VecF operator-(VecF a, VecF b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline VecF operator*(VecF a, VecF b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline VecF operator/(VecF a, VecF b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline VecF fma(VecF a, VecF b, VecF c) {
+  return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+}
+inline VecF min(VecF a, VecF b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline VecF max(VecF a, VecF b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline VecF sqrt(VecF a) { return {_mm256_sqrt_ps(a.v)}; }
+inline VecF floor(VecF a) { return {_mm256_floor_ps(a.v)}; }
+inline VecF round(VecF a) {
+  return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline MaskF operator<(VecF a, VecF b) {
+  return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ);
+}
+inline MaskF operator>(VecF a, VecF b) {
+  return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ);
+}
+inline MaskF maskAnd(MaskF a, MaskF b) { return _mm256_and_ps(a, b); }
+inline MaskF maskOr(MaskF a, MaskF b) { return _mm256_or_ps(a, b); }
+inline MaskF maskAndNot(MaskF a, MaskF b) { return _mm256_andnot_ps(b, a); }
+inline VecF select(MaskF m, VecF a, VecF b) {
+  return {_mm256_blendv_ps(b.v, a.v, m)};
+}
+
+/* 2^n for integral n */
+inline VecF pow2n(VecF n) {
+  const __m256i i = _mm256_add_epi32(_mm256_cvtps_epi32(n.v),
+                                     _mm256_set1_epi32(127));
+  return {_mm256_castsi256_ps(_mm256_slli_epi32(i, 23))};
+}
+
+/* x = m * 2^e with m in [0.5, 1), returns e */
+inline VecF splitExponent(VecF x, VecF &m) {
+  const __m256i i = _mm256_castps_si256(x.v);
+  const __m256i e =
+      _mm256_sub_epi32(_mm256_srli_epi32(i, 23), _mm256_set1_epi32(126));
+  m = {_mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(i, _mm256_set1_epi32(0x007fffff)),
+                      _mm256_set1_epi32(0x3f000000)))};
+  return {_mm256_cvtepi32_ps(e)};
+}
+
+#else
+
+/* The arithmetic, min, max, round and the exponent helpers come with it */
+using VecF = FloatLane;
+using MaskF = bool;
+
+inline VecF load(const float *p) { return {*p}; }
+inline void store(float *p, VecF a) { *p = a.v; }
+inline VecF splat(float x) { return {x}; }
+
+inline VecF sqrt(VecF a) { return {std::sqrt(a.v)}; }
+inline VecF floor(VecF a) { return {std::floor(a.v)}; }
+
+inline MaskF operator>(VecF a, VecF b) { return a.v > b.v; }
+inline MaskF maskAnd(MaskF a, MaskF b) { return a && b; }
+inline MaskF maskOr(MaskF a, MaskF b) { return a || b; }
+inline MaskF maskAndNot(MaskF a, MaskF b) { return a && !b; }
+
+#endif
+
+/* The Cephes kernels of LaneMath.hpp */
+inline VecF vexp(VecF x) { return laneExp(x); }
+/* For x > 0 */
+inline VecF vlog(VecF x) { return laneLog(x); }
+
+/* x^y for x > 0 */
+inline VecF vpow(VecF x, VecF y) { return vexp(y * vlog(x)); }
+
+/* Sine and cosine of an angle in degrees. The reduction to [-45, 45] degrees
+ * is exact, so accuracy does not degrade over the [0, 360] crank range. */
+inline void vsincosDeg(VecF deg, VecF &s, VecF &c) {
+  const VecF q = round(deg * splat(1.f / 90.f));
+  const VecF r = (deg - q * splat(90.f)) * splat(0.017453292519943295f);
+  const VecF z = r * r;
+
+  VecF ps = splat(-1.9515295891e-4f);
+  ps = fma(ps, z, splat(8.3321608736e-3f));
+  ps = fma(ps, z, splat(-1.6666654611e-1f));
+  ps = fma(ps * z, r, r);
+
+  VecF pc = splat(2.443315711809948e-5f);
+  pc = fma(pc, z, splat(-1.388731625493765e-3f));
+  pc = fma(pc, z, splat(4.166664568298827e-2f));
+  pc = fma(pc * z, z, fma(z, splat(-0.5f), splat(1.f)));
+
+  /* Quadrant in [0, 4) */
+  const VecF quad = q - splat(4.f) * floor(q * splat(0.25f));
+  const MaskF odd = (quad - splat(2.f) * floor(quad * splat(0.5f))) >
+                    splat(0.5f);
+  const MaskF sinNeg = quad > splat(1.5f);
+  const MaskF cosNeg = maskAnd(quad > splat(0.5f), quad < splat(2.5f));
+
+  const VecF sv = select(odd, pc, ps);
+  const VecF cv = select(odd, ps, pc);
+  s = select(sinNeg, splat(0.f) - sv, sv);
+  c = select(cosNeg, splat(0.f) - cv, cv);
+}
+
+#endif
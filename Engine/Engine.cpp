@@ -0,0 +1,93 @@
+#include "Engine.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+Engine::Engine(CylinderGeometry geometry, const std::vector<int> &firingOrder,
+               unsigned threads)
+    : headAngle{}, omega{}, externalTorque{}, dynamicsIsActive{true},
+      cycleTrigger{false}, torque{}, pool{threads} {
+  const int n = firingOrder.size();
+
+  /* Every cylinder exactly once, else one would be left at phase 0 */
+  std::vector<int> sorted = firingOrder;
+  std::sort(sorted.begin(), sorted.end());
+  bool permutation = n > 0;
+  for (int i = 0; i < n; ++i) {
+    permutation = permutation && sorted[i] == i + 1;
+  }
+  if (!permutation) {
+    throw std::invalid_argument(
+        "Engine: the firing order is not a permutation of 1..n");
+  }
+
+  phase.assign(n, 0.f);
+  cylinderTorque.assign(n, 0.f);
+
+  /* Evenly spaced firing: the k-th cylinder to fire lags k/n of a cycle */
+  for (int k = 0; k < n; ++k) {
+    phase[firingOrder[k] - 1] = 360.f * k / n;
+  }
+
+  cylinders.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    cylinders.emplace_back(geometry, angleWrapper(headAngle - phase[i]));
+  }
+
+  /* Every cylinder brings its own share of crankshaft and flywheel */
+  momentOfInertia = n * geometry.momentOfInertia;
+}
+
+std::vector<int> Engine::defaultFiringOrder(int cylinders) {
+  switch (cylinders) {
+  case 3:
+    return {1, 3, 2};
+  case 4:
+    return {1, 3, 4, 2};
+  case 5:
+    return {1, 2, 4, 5, 3};
+  case 6:
+    return {1, 5, 3, 6, 2, 4};
+  case 8:
+    return {1, 8, 4, 3, 6, 5, 7, 2};
+  case 10:
+    return {1, 6, 5, 10, 2, 7, 3, 8, 4, 9};
+  case 12:
+    return {1, 7, 5, 11, 3, 9, 6, 12, 2, 8, 4, 10};
+  default:
+    std::vector<int> order(std::max(cylinders, 1));
+    std::iota(order.begin(), order.end(), 1);
+    return order;
+  }
+}
+
+void Engine::applyExtTorque(float torque) { externalTorque = torque; }
+
+void Engine::step(float deltaT, float setSpeed) {
+  const float previousHeadAngle = headAngle;
+  headAngle = angleWrapper(headAngle + RADToDEG(omega) * deltaT / 2);
+
+  /* Per-cylinder kinematics and thermodynamics */
+  auto update = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      cylinders[i].followCrank(angleWrapper(headAngle - phase[i]), omega,
+                               deltaT);
+      cylinderTorque[i] = cylinders[i].getTorque();
+    }
+  };
+  pool.run(cylinders.size(), update);
+
+  /* Summed in a fixed order, so results do not depend on the thread count */
+  torque = std::accumulate(cylinderTorque.begin(), cylinderTorque.end(), 0.f);
+
+  if (dynamicsIsActive) {
+    omega += deltaT * (torque + externalTorque) / momentOfInertia;
+  } else {
+    omega = setSpeed;
+  }
+
+  /* A full cycle of the crankshaft has terminated */
+  if (previousHeadAngle > headAngle) {
+    cycleTrigger = true;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+#include "Piston.hpp"
+#include "WorkerPool.hpp"
+#include <vector>
+
+/* Cylinders sharing one crankshaft. Each cylinder keeps its own Gas and
+ * follows the crank with a phase lag given by the firing order; the
+ * thermodynamics of all cylinders is stepped in parallel and their torques
+ * are summed once per substep. */
+class Engine {
+public:
+  /* Firing order as 1-based cylinder numbers, e.g. {1, 3, 4, 2}, each
+   * cylinder once: throws std::invalid_argument otherwise */
+  Engine(CylinderGeometry geometry, const std::vector<int> &firingOrder,
+         unsigned threads = 1);
+
+  static std::vector<int> defaultFiringOrder(int cylinders);
+
+  void step(float deltaT, float setSpeed);
+  void applyExtTorque(float torque);
+
+  float getTorque() const { return torque; }
+  int getCylinderCount() const { return cylinders.size(); }
+
+  std::vector<Piston> cylinders;
+  std::vector<float> phase; /* Head crank lag of each cylinder [deg] */
+
+  /* Crankshaft */
+  float headAngle;
+  float omega;
+  float momentOfInertia;
+  float externalTorque;
+  bool dynamicsIsActive;
+
+  /* Triggers */
+  bool cycleTrigger;
+
+private:
+  std::vector<float> cylinderTorque;
+  float torque; /* Sum over the cylinders at the last substep */
+
+  WorkerPool pool;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "WorkerPool.hpp"
+
+constexpr int SPIN_ITERATIONS = 20000;
+
+WorkerPool::WorkerPool(unsigned threads)
+    : job{}, ctx{}, count{}, generation{0}, pending{0}, quit{false} {
+  for (unsigned i = 1; i < threads; ++i) {
+    workers.emplace_back(&WorkerPool::work, this, i);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  quit = true;
+  generation.fetch_add(1, std::memory_order_release);
+  generation.notify_all();
+  for (std::thread &t : workers) {
+    t.join();
+  }
+}
+
+void WorkerPool::runSlice(unsigned index) {
+  const size_t begin = count * index / size();
+  const size_t end = count * (index + 1) / size();
+  if (begin < end) {
+    job(ctx, begin, end);
+  }
+}
+
+void WorkerPool::dispatch(size_t n, Job j, void *c) {
+  if (workers.empty()) {
+    j(c, 0, n);
+    return;
+  }
+
+  job = j;
+  ctx = c;
+  count = n;
+  pending.store(workers.size(), std::memory_order_relaxed);
+  generation.fetch_add(1, std::memory_order_release);
+  generation.notify_all();
+
+  runSlice(0);
+
+  for (int i = 0; pending.load(std::memory_order_acquire) != 0; ++i) {
+    if (i > SPIN_ITERATIONS) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void WorkerPool::work(unsigned index) {
+  uint64_t seen = 0;
+  while (true) {
+    /* Spin first, park when the pool has been idle for a while */
+    uint64_t current = generation.load(std::memory_order_acquire);
+    for (int i = 0; current == seen && i < SPIN_ITERATIONS; ++i) {
+      current = generation.load(std::memory_order_acquire);
+    }
+    if (current == seen) {
+      generation.wait(seen, std::memory_order_acquire);
+      continue;
+    }
+    seen = current;
+
+    if (quit.load(std::memory_order_relaxed)) {
+      return;
+    }
+
+    runSlice(index);
+    pending.fetch_sub(1, std::memory_order_release);
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/* Persistent threads for short fork/join jobs issued at substep rate.
+ * Workers spin briefly before parking, so back-to-back jobs are picked up
+ * without a syscall. Work is split statically: a given index always lands on
+ * the same thread. */
+class WorkerPool {
+public:
+  WorkerPool(unsigned threads);
+  ~WorkerPool();
+
+  unsigned size() const { return workers.size() + 1; }
+
+  /* Calls f(begin, end) over [0, count) split across the pool, the calling
+   * thread included, and returns once every range is done. */
+  template <typename F> void run(size_t count, F &f) {
+    dispatch(count, [](void *ctx, size_t b, size_t e) { (*(F *)ctx)(b, e); },
+             &f);
+  }
+
+private:
+  using Job = void (*)(void *ctx, size_t begin, size_t end);
+
+  void dispatch(size_t count, Job job, void *ctx);
+  void work(unsigned index);
+  void runSlice(unsigned index);
+
+  std::vector<std::thread> workers;
+
+  Job job;
+  void *ctx;
+  size_t count;
+
+  std::atomic<uint64_t> generation;
+  std::atomic<unsigned> pending;
+  std::atomic<bool> quit;
+};
+
+#endif
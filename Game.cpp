@@ -10,19 +10,23 @@ Game::Game(const char *title, int xpos, int ypos, int height, int width) {
 bool Game::isGameRunning() { return isRunning; }
 
 void Game::handleEvents() {
+  /* Everything queued since the last frame, a drag produces many */
   SDL_Event event;
-  SDL_PollEvent(&event);
-
-  switch (event.type) {
-  case SDL_QUIT:
-    isRunning = false;
-    break;
-
-  default:
-    break;
+  while (SDL_PollEvent(&event)) {
+    switch (event.type) {
+    case SDL_QUIT:
+      isRunning = false;
+      break;
+
+    default:
+      break;
+    }
+
+    ImGui_ImplSDL2_ProcessEvent(&event);
+    if (onEvent) {
+      onEvent(event);
+    }
   }
-
-  ImGui_ImplSDL2_ProcessEvent(&event);
 }
 
 void Game::RenderClear() { SDL_RenderClear(renderer); }
@@ -5,6 +5,7 @@
 #include "imgui_impl_sdlrenderer2.h"
 #include <SDL2/SDL.h>
 #include "implot.h"
+#include <functional>
 #include <stdio.h>
 #include <string>
 
@@ -19,6 +20,8 @@ public:
   void QuitGame();
 
   bool isRunning;
+  /* Called by handleEvents() for every event, after ImGui saw it */
+  std::function<void(const SDL_Event &event)> onEvent;
   SDL_Window *window;
   SDL_Renderer *renderer;
 
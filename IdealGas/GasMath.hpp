@@ -0,0 +1,47 @@
+#ifndef GASMATH_HPP
+#define GASMATH_HPP
+#include "LaneMath.hpp"
+#include <cmath>
+
+/* Precision policies of the gas model, selected at compile time through the
+ * Math parameter of BasicIdealGas/BasicGas/BasicPiston. Both provide exp(x)
+ * and pow(x, y) for x > 0. */
+
+/* The C library, correctly rounded or within an ulp, for any scalar type */
+struct ExactMath {
+  template <typename T> static T exp(T x) { return std::exp(x); }
+  template <typename T> static T pow(T x, T y) { return std::pow(x, y); }
+};
+
+/* The short kernels of LaneMath.hpp, single precision only. Maximum
+ * relative errors, measured by precision_check:
+ *   exp(x)     1.4e-5, x clamped to [-87.3, 88.3]
+ *   pow(x, y)  1.4e-5 for y = -1.4 and x in [0.5, 2]
+ *   pow(x, y)  1.4e-5 for x = 0.93 and y in [0, 10]
+ * The error shrinks with |x| of exp and |y log x| of pow: 7.9e-7 up to 0.1,
+ * float rounding, 1.2e-7, up to 0.01, where the steps of the gas model stay.
+ * Arguments in the range of the cores
+ * skip the reduction: a branch the gas model always takes, which cuts the
+ * chain of dependent operations below glibc's expf/powf. The result is the
+ * same either way. The FastMath instantiations are compiled for the host
+ * CPU, for its FMA, unless ENGINE_FASTMATH_NATIVE is off. */
+struct FastMath {
+  static constexpr float EXP_CORE = 0.34657359f; /* ln2 / 2 */
+  static constexpr float LOG_CORE_LOW = 0.70710678f;
+  static constexpr float LOG_CORE_HIGH = 1.41421356f;
+
+  static float exp(float x) {
+    const FloatLane lane{x};
+    return (std::fabs(x) < EXP_CORE ? laneExpCore(lane) : laneQuickExp(lane))
+        .v;
+  }
+  static float pow(float x, float y) {
+    const FloatLane lane{x};
+    const FloatLane log = (x >= LOG_CORE_LOW && x < LOG_CORE_HIGH)
+                              ? laneLogCore(lane)
+                              : laneQuickLog(lane);
+    return exp(y * log.v);
+  }
+};
+
+#endif
@@ -1,48 +1,93 @@
 #ifndef IDEALGAS_HPP
 #define IDEALGAS_HPP
+#include "GasMath.hpp"
+#include <concepts>
 
 constexpr float DEFAULT_AMBIENT_PRESSURE = 101325.f;
 constexpr float DEFAULT_AMBIENT_TEMPERATURE = 300.f;
 constexpr float ZERO_CELSIUS_IN_KELVIN = 273.15f;
-constexpr float PAToATM(float X) { return ((X) / DEFAULT_AMBIENT_PRESSURE); }
-constexpr float KELVToCELS(float X) { return ((X)-ZERO_CELSIUS_IN_KELVIN); }
+constexpr float R_AIR = 287.05f; /* Specific gas constant of air [J/(kg K)] */
+template <std::floating_point T> constexpr T PAToATM(T X) {
+  return ((X) / DEFAULT_AMBIENT_PRESSURE);
+}
+template <std::floating_point T> constexpr T KELVToCELS(T X) {
+  return ((X)-ZERO_CELSIUS_IN_KELVIN);
+}
+template <std::floating_point T> constexpr T NRToKG(T X) {
+  return ((X) / R_AIR);
+}
 
-class IdealGas {
+/* T is the scalar type of the state, Math the precision policy of the
+ * transcendentals, see GasMath.hpp */
+template <typename T, typename Math = ExactMath> class BasicIdealGas {
 
 public:
-  float getP() { return pressure; };
-  float getV() { return volume; };
-  float getnR() { return nR; };
-  float getT() { return temperature; };
+  T getP() const { return pressure; };
+  T getV() const { return volume; };
+  T getnR() const { return nR; };
+  T getT() const { return temperature; };
 
-  IdealGas(float p, float v, float t);
+  BasicIdealGas() = default;
+  BasicIdealGas(T p, T v, T t);
 
   /* Ideal process */
-  void AdiabaticCompress(float vprime, float dt);
-  float SimpleFlow(float kFlow, float ext_pressure, float ext_temp, float dt);
-  void HeatExchange(float kTherm, float ext_temp, float dt);
+  void AdiabaticCompress(T vprime, T dt);
+  T SimpleFlow(T kFlow, T ext_pressure, T ext_temp, T dt);
+  void HeatExchange(T kTherm, T ext_temp, T dt);
+
+  /* Passes every state member to archive(...), e.g. for checkpoints */
+  template <typename Archive> void serialize(Archive &archive) {
+    archive(pressure, volume, nR, temperature);
+  }
 
 protected:
-  float pressure;
-  float volume;
-  float nR;
-  float temperature;
+  T pressure{};
+  T volume{};
+  T nR{};
+  T temperature{};
 
-  const float alpha = 5.f / 2.f;
+  static constexpr T alpha = T(5) / 2;
 };
 
-class Gas : public IdealGas {
+template <typename T, typename Math = ExactMath>
+class BasicGas : public BasicIdealGas<T, Math> {
 
 public:
-  Gas(float p, float v, float t, float o);
+  BasicGas() = default;
+  BasicGas(T p, T v, T t, T o);
+
+  T getOx() const { return ox; };
+  T SimpleFlow(T kFlow, T ext_pressure, T ext_temp, T ext_ox, T dt);
+  T InjectHeat(T kx, T dt);
+
+  /* Richardson extrapolation of a first order process: this state went
+   * through two half steps, coarse through one whole step. Quantities that
+   * would leave their physical range keep the half step value. */
+  void Extrapolate(const BasicGas &coarse);
 
-  float getOx() { return ox; };
-  float SimpleFlow(float kFlow, float ext_pressure, float ext_temp,
-                   float ext_ox, float dt);
-  void InjectHeat(float kx, float dt);
+  template <typename Archive> void serialize(Archive &archive) {
+    BasicIdealGas<T, Math>::serialize(archive);
+    archive(ox);
+  }
 
 private:
-  float ox; // Oxygenation level [0, 1]
+  using BasicIdealGas<T, Math>::pressure;
+  using BasicIdealGas<T, Math>::volume;
+  using BasicIdealGas<T, Math>::nR;
+  using BasicIdealGas<T, Math>::temperature;
+  using BasicIdealGas<T, Math>::alpha;
+
+  T ox{}; // Oxygenation level [0, 1]
 };
 
+extern template class BasicIdealGas<float, ExactMath>;
+extern template class BasicIdealGas<float, FastMath>;
+extern template class BasicIdealGas<double, ExactMath>;
+extern template class BasicGas<float, ExactMath>;
+extern template class BasicGas<float, FastMath>;
+extern template class BasicGas<double, ExactMath>;
+
+using IdealGas = BasicIdealGas<float>;
+using Gas = BasicGas<float>;
+
 #endif
@@ -0,0 +1,5 @@
+#include "IdealGasImpl.hpp"
+
+/* Compiled for the host CPU where the build allows, see CMakeLists.txt */
+template class BasicIdealGas<float, FastMath>;
+template class BasicGas<float, FastMath>;
@@ -0,0 +1,159 @@
+#ifndef IDEALGASIMPL_HPP
+#define IDEALGASIMPL_HPP
+#include "IdealGas.hpp"
+#include <cmath>
+
+/* Member definitions of the gas models, for the translation units that
+ * instantiate them: IdealGas.cpp and IdealGasFastMath.cpp */
+
+template <typename T, typename Math>
+BasicIdealGas<T, Math>::BasicIdealGas(T p, T v, T t) {
+  pressure = p;
+  volume = v;
+  temperature = t;
+  nR = pressure * volume / temperature;
+}
+
+template <typename T, typename Math>
+void BasicIdealGas<T, Math>::AdiabaticCompress(T vprime, T dt) {
+  /* Compute the pressure variation */
+  const T p0 = pressure;
+  const T v0 = volume;
+  const T v = v0 + vprime * dt;
+  const T p = p0 * Math::pow((v / v0), T(-1.4));
+
+  /* Update the status */
+  pressure = p;
+  volume = v;
+  temperature = pressure * volume / nR;
+}
+
+template <typename T, typename Math>
+T BasicIdealGas<T, Math>::SimpleFlow(T kFlow, T ext_pressure, T ext_temp,
+                                     T dt) {
+  /* SIMPLIFIED VERSION - TEMPERATURE VARIATION */
+  /* Compute the pressure variation */
+  const T a = temperature / volume;
+  const T b = ext_pressure;
+  const T p0 = pressure;
+  const T c1 = p0 - b;
+  const T p = c1 * Math::exp(-a * kFlow * dt) + b;
+
+  const T deltaP = (b - p0);
+  const T nrPrime = kFlow * deltaP;
+
+  const T tout = ext_temp;
+  const T nr0 = nR;
+
+  /* Update the status */
+  pressure = p;
+  nR += nrPrime * dt;
+
+  /* Weighted average of entering and internal fluid */
+  const T adjT = pressure * volume / nR;
+  const T t = (dt * nrPrime * tout + nr0 * adjT) / nR;
+
+  temperature = t;
+
+  return nrPrime * dt;
+}
+
+template <typename T, typename Math>
+void BasicIdealGas<T, Math>::HeatExchange(T kTherm, T ext_temp, T dt) {
+  const T t0 = temperature;
+  const T p0 = pressure;
+  const T c = ext_temp;
+  const T b = volume;
+  const T r = nR;
+
+  const T y1 = t0 - c;
+  const T y2 = p0 - c * r / b;
+
+  const T expo = Math::exp(kTherm * dt / (alpha * r));
+  const T t = y1 * expo + c;
+  const T p = (1 - expo) * r * y1 / b + y2 + c * r / b;
+
+  /* Update the status */
+  temperature = t;
+  pressure = p;
+}
+
+template <typename T, typename Math>
+BasicGas<T, Math>::BasicGas(T p, T v, T t, T o)
+    : BasicIdealGas<T, Math>::BasicIdealGas(p, v, t) {
+  ox = o;
+}
+
+template <typename T, typename Math>
+T BasicGas<T, Math>::SimpleFlow(T kFlow, T ext_pressure, T ext_temp, T ext_ox,
+                                T dt) {
+  /* SIMPLIFIED VERSION - TEMPERATURE VARIATION */
+  /* Compute the pressure variation */
+  const T a = temperature / volume;
+  const T b = ext_pressure;
+  const T p0 = pressure;
+  const T c1 = p0 - b;
+  const T p = c1 * Math::exp(-a * kFlow * dt) + b;
+
+  const T deltaP = (b - p0);
+  const T nrPrime = kFlow * deltaP;
+
+  const T tout = ext_temp;
+  const T nr0 = nR;
+
+  /* Update the status */
+  pressure = p;
+  nR += nrPrime * dt;
+
+  /* Weighted average of entering and internal fluid */
+  if (nrPrime > 0) {
+    const T ox0 = ox;
+    const T ox1 = (dt * nrPrime * ext_ox + nr0 * ox0) / nR;
+
+    ox = ox1;
+
+    const T adjT = pressure * volume / nR;
+    const T t = (dt * nrPrime * tout + nr0 * adjT) / nR;
+
+    temperature = t;
+  }
+
+  return nrPrime * dt;
+}
+
+template <typename T, typename Math>
+T BasicGas<T, Math>::InjectHeat(T kx, T dt) {
+  const T t0 = temperature;
+  const T p0 = pressure;
+
+  const T qprime = 10000 * kx * nR * ox / dt;
+
+  const T t = t0 + dt * qprime / (alpha * nR);
+  const T p = p0 + dt * qprime / (alpha * volume);
+
+  temperature = t;
+  pressure = p;
+  ox *= (1 - kx);
+
+  return qprime * dt;
+}
+
+template <typename T, typename Math>
+void BasicGas<T, Math>::Extrapolate(const BasicGas &coarse) {
+  const T p = 2 * pressure - coarse.pressure;
+  const T t = 2 * temperature - coarse.temperature;
+  const T r = 2 * nR - coarse.nR;
+  const T o = 2 * ox - coarse.ox;
+
+  /* Update the status */
+  if (p > 0 && t > 0 && r > 0) {
+    pressure = p;
+    temperature = t;
+    nR = r;
+  }
+  if (o >= 0 && o <= 1) {
+    ox = o;
+  }
+}
+
+#endif
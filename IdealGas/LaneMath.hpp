@@ -0,0 +1,151 @@
+#ifndef LANEMATH_HPP
+#define LANEMATH_HPP
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+/* Exp and log kernels, written once for any lane type V: a single float
+ * (FloatLane) or a SIMD vector (VecF of Batch/SimdVec.hpp). Cephes expf and
+ * logf for the batch kernels, shorter ones behind FastMath. No data
+ * dependent branch, so the same code serves every lane of a vector. The
+ * operations are found by argument dependent lookup: V needs +, -, *, /, <,
+ * fma, min, max, round, select, pow2n, splitExponent, and splat(V, c) for
+ * the constant c in every lane. */
+
+/* About 1 ulp. The clamp keeps 2^n finite and normal. */
+template <typename V> inline V laneExp(V x) {
+  x = min(max(x, splat(x, -87.3f)), splat(x, 88.3f));
+  const V n = round(x * splat(x, 1.44269504088896341f));
+  /* x = n ln2 + r, ln2 split in two so that n times the leading part is
+   * exact */
+  V r = fma(n, splat(x, -0.693359375f), x);
+  r = fma(n, splat(x, 2.12194440e-4f), r);
+
+  /* Minimax polynomial by Estrin's scheme: the chain of dependent
+   * multiply-adds is half as long as Horner's */
+  const V r2 = r * r;
+  const V p45 = fma(r, splat(x, 1.6666665459e-1f), splat(x, 5.0000001201e-1f));
+  const V p23 = fma(r, splat(x, 8.3334519073e-3f), splat(x, 4.1665795894e-2f));
+  const V p01 = fma(r, splat(x, 1.9875691500e-4f), splat(x, 1.3981999507e-3f));
+  const V p = fma(r2 * r2, p01, fma(r2, p23, p45));
+  const V y = fma(p, r2, r + splat(x, 1.f));
+  return y * pow2n(n);
+}
+
+/* For x > 0, about 2 ulp */
+template <typename V> inline V laneLog(V x) {
+  V m;
+  V e = splitExponent(x, m);
+  const auto small = m < splat(x, 0.707106781186547524f);
+  e = select(small, e - splat(x, 1.f), e);
+  m = select(small, m + m, m) - splat(x, 1.f);
+
+  /* Estrin's scheme again */
+  const V z = m * m;
+  const V z2 = z * z;
+  const V q01 = fma(m, splat(x, -2.4999993993e-1f), splat(x, 3.3333331174e-1f));
+  const V q23 = fma(m, splat(x, -1.6668057665e-1f), splat(x, 2.0000714765e-1f));
+  const V q45 = fma(m, splat(x, -1.2420140846e-1f), splat(x, 1.4249322787e-1f));
+  const V q67 = fma(m, splat(x, -1.1514610310e-1f), splat(x, 1.1676998740e-1f));
+  const V high = fma(z2, splat(x, 7.0376836292e-2f), fma(z, q67, q45));
+  V y = fma(z2, high, fma(z, q23, q01));
+  y = y * m * z;
+  y = fma(e, splat(x, -2.12194440e-4f), y);
+  y = fma(z, splat(x, -0.5f), y);
+  return fma(e, splat(x, 0.693359375f), m + y);
+}
+
+/* Shorter kernels, for speed over the last digits. The leading terms, 1 + r
+ * of exp and 2s of the atanh series of log, are exact, so the error shrinks
+ * toward 0 for exp and 1 for log, where the gas model's arguments are:
+ *   exp(x)  within 1.4e-5 relative, x clamped to [-87.3, 88.3]
+ *   log(x)  within 2e-7 absolute, 4.7e-7 relative for x in [0.707, 1.414]
+ * Each reduces its argument to the range of a core, which scalar callers
+ * can call directly for arguments already in it. */
+
+/* e^r for |r| <= ln2 / 2: 1 + r + r^2 q(r), q of degree 2 */
+template <typename V> inline V laneExpCore(V r) {
+  const V r2 = r * r;
+  const V q01 = fma(r, splat(r, 1.6741898670e-1f), splat(r, 0.5f));
+  const V q = fma(r2, splat(r, 4.1791986113e-2f), q01);
+  return fma(r2, q, r + splat(r, 1.f));
+}
+
+/* log m for m in [0.707, 1.414]: 2 atanh s, s = (m - 1) / (m + 1) within
+ * 0.172, as 2s + s^3 q(s^2), q of degree 1 */
+template <typename V> inline V laneLogCore(V m) {
+  const V s = (m - splat(m, 1.f)) / (m + splat(m, 1.f));
+  const V s2 = s * s;
+  const V q = fma(s2, splat(m, 4.0858269359e-1f), splat(m, 6.6663499455e-1f));
+  return fma(s * s2, q, s + s);
+}
+
+/* The clamp is on n, off the path of the polynomial */
+template <typename V> inline V laneQuickExp(V x) {
+  V n = round(x * splat(x, 1.44269504088896341f));
+  V r = fma(n, splat(x, -0.693359375f), x);
+  r = fma(n, splat(x, 2.12194440e-4f), r);
+  n = min(max(n, splat(x, -126.f)), splat(x, 127.f));
+  return laneExpCore(r) * pow2n(n);
+}
+
+template <typename V> inline V laneQuickLog(V x) {
+  V m;
+  V e = splitExponent(x, m);
+  const auto small = m < splat(x, 0.707106781186547524f);
+  e = select(small, e - splat(x, 1.f), e);
+  m = select(small, m + m, m);
+  return fma(e, splat(x, 0.693147180559945309f), laneLogCore(m));
+}
+
+/* One float as a lane */
+struct FloatLane {
+  static constexpr int width = 1;
+  float v;
+};
+
+inline FloatLane splat(FloatLane, float x) { return {x}; }
+inline FloatLane operator+(FloatLane a, FloatLane b) { return {a.v + b.v}; }
+inline FloatLane operator-(FloatLane a, FloatLane b) { return {a.v - b.v}; }
+inline FloatLane operator*(FloatLane a, FloatLane b) { return {a.v * b.v}; }
+inline FloatLane operator/(FloatLane a, FloatLane b) { return {a.v / b.v}; }
+inline bool operator<(FloatLane a, FloatLane b) { return a.v < b.v; }
+/* std::fma is a library call without hardware FMA, a plain multiply-add
+ * then */
+inline FloatLane fma(FloatLane a, FloatLane b, FloatLane c) {
+#if defined(__FMA__)
+  return {std::fma(a.v, b.v, c.v)};
+#else
+  return {a.v * b.v + c.v};
+#endif
+}
+inline FloatLane min(FloatLane a, FloatLane b) {
+  return {(b.v < a.v) ? b.v : a.v};
+}
+inline FloatLane max(FloatLane a, FloatLane b) {
+  return {(a.v < b.v) ? b.v : a.v};
+}
+/* To nearest even by adding 1.5 * 2^23, for |a| < 2^22 which is all the
+ * kernels need: std::nearbyint is a library call without SSE4.1 */
+inline FloatLane round(FloatLane a) {
+  return {(a.v + 12582912.f) - 12582912.f};
+}
+inline FloatLane select(bool m, FloatLane a, FloatLane b) {
+  return m ? a : b;
+}
+
+/* 2^n for integral n */
+inline FloatLane pow2n(FloatLane n) {
+  const int32_t i = (static_cast<int32_t>(n.v) + 127) << 23;
+  return {std::bit_cast<float>(i)};
+}
+
+/* x = m * 2^e with m in [0.5, 1), returns e */
+inline FloatLane splitExponent(FloatLane x, FloatLane &m) {
+  const int32_t i = std::bit_cast<int32_t>(x.v);
+  const int32_t e = (i >> 23) - 126;
+  m = {std::bit_cast<float>((i & 0x007fffff) | 0x3f000000)};
+  return {static_cast<float>(e)};
+}
+
+#endif
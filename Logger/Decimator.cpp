@@ -0,0 +1,123 @@
+#include "Decimator.hpp"
+#include <cmath>
+
+static bool copyIfSmall(std::span<const float> in, int points,
+                        std::vector<float> &x, std::vector<float> &y) {
+  x.clear();
+  y.clear();
+  if (static_cast<int>(in.size()) > points) {
+    return false;
+  }
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    x.push_back(static_cast<float>(i));
+    y.push_back(in[i]);
+  }
+  return true;
+}
+
+void decimateMinMax(std::span<const float> in, int points,
+                    std::vector<float> &x, std::vector<float> &y) {
+  if (copyIfSmall(in, points, x, y) || points < 2) {
+    return;
+  }
+
+  /* Two points per bucket */
+  const size_t buckets = points / 2;
+  const size_t n = in.size();
+  for (size_t b = 0; b < buckets; ++b) {
+    const size_t first = b * n / buckets;
+    const size_t last = (b + 1) * n / buckets;
+
+    size_t lo = first;
+    size_t hi = first;
+    for (size_t i = first + 1; i < last; ++i) {
+      if (in[i] < in[lo]) {
+        lo = i;
+      }
+      if (in[i] > in[hi]) {
+        hi = i;
+      }
+    }
+
+    /* In sample order, so the line does not go back in x */
+    const size_t a = (lo < hi) ? lo : hi;
+    const size_t c = (lo < hi) ? hi : lo;
+    x.push_back(static_cast<float>(a));
+    y.push_back(in[a]);
+    x.push_back(static_cast<float>(c));
+    y.push_back(in[c]);
+  }
+}
+
+void decimateLttb(std::span<const float> in, int points, std::vector<float> &x,
+                  std::vector<float> &y) {
+  if (copyIfSmall(in, points, x, y) || points < 3) {
+    return;
+  }
+
+  /* First and last samples are kept, the rest is split in buckets */
+  const size_t n = in.size();
+  const size_t buckets = points - 2;
+  const auto bucketStart = [&](size_t b) { return 1 + b * (n - 2) / buckets; };
+
+  size_t a = 0;
+  x.push_back(0.f);
+  y.push_back(in[0]);
+
+  for (size_t b = 0; b < buckets; ++b) {
+    /* Average of the next bucket, the last sample for the last one */
+    const size_t nextFirst = bucketStart(b + 1);
+    const size_t nextLast = (b + 1 < buckets) ? bucketStart(b + 2) : n;
+    double avgX = 0.0;
+    double avgY = 0.0;
+    for (size_t i = nextFirst; i < nextLast; ++i) {
+      avgX += i;
+      avgY += in[i];
+    }
+    const size_t count = nextLast - nextFirst;
+    avgX /= count;
+    avgY /= count;
+
+    /* Sample forming the largest triangle with a and the next average */
+    size_t best = bucketStart(b);
+    double bestArea = -1.0;
+    for (size_t i = bucketStart(b); i < nextFirst; ++i) {
+      const double area =
+          std::fabs((a - avgX) * (in[i] - in[a]) -
+                    (a - static_cast<double>(i)) * (avgY - in[a]));
+      if (area > bestArea) {
+        bestArea = area;
+        best = i;
+      }
+    }
+
+    x.push_back(static_cast<float>(best));
+    y.push_back(in[best]);
+    a = best;
+  }
+
+  x.push_back(static_cast<float>(n - 1));
+  y.push_back(in[n - 1]);
+}
+
+DecimatedSeries::DecimatedSeries(Decimation method)
+    : method{method}, valid{false}, version{0}, points{0} {}
+
+bool DecimatedSeries::update(std::span<const float> data, uint64_t v,
+                             int budget) {
+  if (valid && v == version && budget == points) {
+    return false;
+  }
+
+  if (method == Decimation::Lttb) {
+    decimateLttb(data, budget, x, y);
+  } else {
+    decimateMinMax(data, budget, x, y);
+  }
+
+  valid = true;
+  version = v;
+  points = budget;
+  return true;
+}
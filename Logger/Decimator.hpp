@@ -0,0 +1,44 @@
+#ifndef DECIMATOR_HPP_
+#define DECIMATOR_HPP_
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/* Reduce a series to at most `points` (x, y) pairs, x being the sample index.
+ * Series that already fit are copied unchanged. */
+
+/* Keeps the minimum and the maximum of every bucket: no peak is lost, which
+ * suits spiky channels like pressure and torque */
+void decimateMinMax(std::span<const float> in, int points,
+                    std::vector<float> &x, std::vector<float> &y);
+
+/* Largest-Triangle-Three-Buckets: keeps the visually dominant sample of
+ * every bucket, best for smooth channels */
+void decimateLttb(std::span<const float> in, int points, std::vector<float> &x,
+                  std::vector<float> &y);
+
+enum class Decimation { MinMax, Lttb };
+
+/* Decimated copy of a logged channel, recomputed only when the data version
+ * (e.g. the cycle count) or the point budget changes */
+class DecimatedSeries {
+public:
+  DecimatedSeries(Decimation method = Decimation::MinMax);
+
+  /* Returns whether the series was recomputed */
+  bool update(std::span<const float> data, uint64_t version, int points);
+
+  const float *getX() const { return x.data(); }
+  const float *getY() const { return y.data(); }
+  int getSize() const { return static_cast<int>(y.size()); }
+
+private:
+  Decimation method;
+  bool valid;
+  uint64_t version;
+  int points;
+  std::vector<float> x;
+  std::vector<float> y;
+};
+
+#endif
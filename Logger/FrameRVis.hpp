@@ -1,8 +1,8 @@
 #ifndef FRAMERVIS_H_
 #define FRAMERVIS_H_
 
+#include "Logger.hpp"
 #include <chrono>
-#include <vector>
 
 using namespace std::chrono;
 
@@ -10,15 +10,10 @@ class FrameRVis {
 private:
   high_resolution_clock::time_point start;
   high_resolution_clock::time_point end;
-  int lastDuration;
-  std::vector<float> v;
+  int lastDuration = 0;
+  Logger v{100}; /* Last framerates, O(1) per frame */
 
-  void addSample(float sample) {
-    v.push_back(sample);
-    if (v.size() > 100) {
-      v.erase(v.begin());
-    }
-  }
+  void addSample(float sample) { v.addSample(sample); }
 
 public:
   void startClock() { start = high_resolution_clock::now(); }
@@ -33,13 +28,13 @@ public:
     return lastDuration / 1000.f;
   }
 
-  size_t getSize() { return v.size(); }
+  size_t getSize() { return v.getSize(); }
 
-  float *getData() { return v.data(); }
+  const float *getData() { return v.getData(); }
 
   float getFramerate() {
-    if (!v.empty()) {
-      return v.back();
+    if (v.getSize() > 0) {
+      return v.getData()[v.getSize() - 1];
     }
     return 0.f;
   }
@@ -1,50 +1,48 @@
 #include "Logger.hpp"
 
-Logger::Logger(int max_size) { this->max_size = max_size; }
+Logger::Logger(int max_size)
+    : max_size{max_size}, head{0}, size{0}, v(2 * max_size) {}
 
 void Logger::addSample(float sample) {
-  v.push_back(sample);
-  if (v.size() > max_size) {
-    v.erase(v.begin());
+  if (size < max_size) {
+    v[size] = sample;
+    v[size + max_size] = sample;
+    ++size;
+  } else {
+    /* Overwrite the oldest sample and slide the window by one */
+    v[head] = sample;
+    v[head + max_size] = sample;
+    head = (head + 1 < max_size) ? head + 1 : 0;
   }
 }
 
-float *Logger::getData() { return v.data(); }
+const float *Logger::getData() const { return v.data() + head; }
 
-int Logger::getSize() { return v.size(); }
+int Logger::getSize() const { return size; }
 
-void CycleLogger::addSample(float sample) {
-  if (which == 0) {
-    a.push_back(sample);
-  } else {
-    b.push_back(sample);
-  }
+std::span<const float> Logger::getV() const {
+  return {getData(), static_cast<size_t>(size)};
 }
 
-float *CycleLogger::getData() {
-  if (which == 0) {
-    return b.data();
-  } else {
-    return a.data();
-  }
+CycleLogger::CycleLogger(int capacity)
+    : capacity{capacity}, buffer{std::vector<float>(capacity),
+                                 std::vector<float>(capacity)} {}
+
+const float *CycleLogger::getData() const { return buffer[1 - which].data(); }
+
+int CycleLogger::getSize() const { return size[1 - which]; }
+
+std::span<const float> CycleLogger::getV() const {
+  return {getData(), static_cast<size_t>(getSize())};
 }
 
-int CycleLogger::getSize() {
-  if (which == 0) {
-    return b.size();
-  } else {
-    return a.size();
-  }
+std::span<const float> CycleLogger::getCurrent() const {
+  return {buffer[which].data(), static_cast<size_t>(size[which])};
 }
 
 void CycleLogger::trig() {
-  if (which == 0) {
-    which = 1;
-    b.clear();
-  } else {
-    which = 0;
-    a.clear();
-  }
+  which = 1 - which;
+  size[which] = 0;
+  overflow[which] = false;
+  ++cycleCount;
 }
-
-std::vector<float> CycleLogger::getV() { return (which == 0) ? a : b; }
@@ -1,31 +1,67 @@
 #ifndef LOGGER_HPP_
 #define LOGGER_HPP_
+#include <cstdint>
+#include <span>
 #include <vector>
 
+/* Enough for a full cycle at 100 kHz and 100 rad/s */
+constexpr int DEFAULT_CYCLE_CAPACITY = 1 << 15;
+
+/* Sliding window over the last max_size samples. Every sample is written
+ * twice, max_size apart, so the window is always contiguous in memory and an
+ * append costs O(1). */
 class Logger {
 public:
   Logger(int max_size);
   void addSample(float sample);
-  float *getData();
-  int getSize();
+  const float *getData() const;
+  int getSize() const;
+  std::span<const float> getV() const;
 
 private:
   int max_size;
+  int head; /* Index of the oldest sample */
+  int size;
   std::vector<float> v;
 };
 
+/* Double-buffered, fixed capacity log of one engine cycle. Samples go to the
+ * current buffer until trig() swaps it with the completed one. No memory is
+ * allocated after construction: samples beyond the capacity are dropped. */
 class CycleLogger {
 private:
-  int which;
-  std::vector<float> a;
-  std::vector<float> b;
+  int capacity;
+  int which = 0;
+  int size[2] = {0, 0};
+  std::vector<float> buffer[2];
+  uint64_t cycleCount = 0;
+  bool overflow[2] = {false, false};
 
 public:
+  CycleLogger(int capacity = DEFAULT_CYCLE_CAPACITY);
+
   void trig();
-  void addSample(float sample);
-  float *getData();
-  int getSize();
-  std::vector<float> getV();
+  void addSample(float sample) {
+    if (size[which] < capacity) {
+      buffer[which][size[which]++] = sample;
+    } else {
+      overflow[which] = true;
+    }
+  }
+
+  /* Last completed cycle */
+  const float *getData() const;
+  int getSize() const;
+  std::span<const float> getV() const;
+
+  /* Cycle in progress */
+  std::span<const float> getCurrent() const;
+
+  /* Number of completed cycles, identifies the data behind getV() */
+  uint64_t getCycleCount() const { return cycleCount; }
+  int getCapacity() const { return capacity; }
+  /* Whether the last completed cycle was truncated to the capacity */
+  bool hasOverflowed() const { return overflow[1 - which]; }
 };
 
 #endif
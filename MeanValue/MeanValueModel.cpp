@@ -0,0 +1,172 @@
+#include "MeanValueModel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+/* Cell of x on axis and the weight of its upper point, NaN at the lower
+ * edge */
+static int cell(const SweepAxis &axis, float x, float &weight) {
+  if (axis.count < 2 || axis.max <= axis.min || std::isnan(x)) {
+    weight = 0.f;
+    return 0;
+  }
+  const float fraction =
+      std::clamp((x - axis.min) / (axis.max - axis.min), 0.f, 1.f);
+  const float position = fraction * (axis.count - 1);
+  const int i = std::min(static_cast<int>(position), axis.count - 2);
+  weight = position - i;
+  return i;
+}
+
+/* Points the detailed model left NaN, a stall or a step too coarse for the
+ * speed, take the nearest finite speed of the same row; no finite one at
+ * all gives fallback */
+static void fillRow(std::vector<MeanValuePoint> &points, size_t first,
+                    size_t stride, int count, float MeanValuePoint::*field,
+                    float fallback) {
+  for (int s = 0; s < count; ++s) {
+    float &value = points[first + s * stride].*field;
+    if (std::isfinite(value)) {
+      continue;
+    }
+    value = fallback;
+    for (int d = 1; d < count; ++d) {
+      const int near[] = {s - d, s + d};
+      const auto found = std::find_if(
+          std::begin(near), std::end(near), [&](int n) {
+            return n >= 0 && n < count &&
+                   std::isfinite(points[first + n * stride].*field);
+          });
+      if (found != std::end(near)) {
+        value = points[first + *found * stride].*field;
+        break;
+      }
+    }
+  }
+}
+
+MeanValueTable MeanValueTable::build(const Piston &calibration,
+                                     const MeanValueSettings &settings,
+                                     unsigned threads, CycleCache *cache) {
+  MeanValueTable table;
+  table.calibration = calibration;
+  table.settings = settings;
+
+  const SweepGrid grid = {
+      .throttle = settings.throttle,
+      .speed = settings.speed,
+      .combustionAdvance = settings.advance,
+      .kexpl = {calibration.kexpl, calibration.kexpl, 1}};
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  const std::vector<CycleResult> results =
+      runSweep(calibration, grid, settings.sweep, threads, cache);
+
+  table.points.reserve(results.size());
+  for (const CycleResult &r : results) {
+    table.points.push_back({r.torque, r.airflow, r.exhaustTemperature});
+  }
+
+  const size_t stride = settings.throttle.count;
+  for (int a = 0; a < settings.advance.count; ++a) {
+    for (int t = 0; t < settings.throttle.count; ++t) {
+      const size_t first = table.index(0, t, a);
+      const int count = settings.speed.count;
+      fillRow(table.points, first, stride, count, &MeanValuePoint::torque,
+              0.f);
+      fillRow(table.points, first, stride, count, &MeanValuePoint::airflow,
+              0.f);
+      fillRow(table.points, first, stride, count,
+              &MeanValuePoint::exhaustTemperature,
+              DEFAULT_AMBIENT_TEMPERATURE);
+    }
+  }
+  return table;
+}
+
+size_t MeanValueTable::index(int s, int t, int a) const {
+  return (static_cast<size_t>(a) * settings.speed.count + s) *
+             settings.throttle.count +
+         t;
+}
+
+static MeanValuePoint lerp(const MeanValuePoint &a, const MeanValuePoint &b,
+                           float w) {
+  return {a.torque + w * (b.torque - a.torque),
+          a.airflow + w * (b.airflow - a.airflow),
+          a.exhaustTemperature +
+              w * (b.exhaustTemperature - a.exhaustTemperature)};
+}
+
+MeanValuePoint MeanValueTable::at(float speed, float throttle,
+                                  float advance) const {
+  float ws, wt, wa;
+  const int s = cell(settings.speed, speed, ws);
+  const int t = cell(settings.throttle, throttle, wt);
+  const int a = cell(settings.advance, advance, wa);
+
+  /* Trilinear, a single point axis has no upper neighbour */
+  const size_t rows = settings.throttle.count;
+  const size_t dt = (settings.throttle.count > 1) ? 1 : 0;
+  const size_t ds = (settings.speed.count > 1) ? rows : 0;
+  const size_t da = (settings.advance.count > 1) ? rows * settings.speed.count
+                                                 : 0;
+  const MeanValuePoint *p = &points[index(s, t, a)];
+  const auto alongThrottle = [&](size_t offset) {
+    return lerp(p[offset], p[offset + dt], wt);
+  };
+  const auto alongSpeed = [&](size_t offset) {
+    return lerp(alongThrottle(offset), alongThrottle(offset + ds), ws);
+  };
+  return lerp(alongSpeed(0), alongSpeed(da), wa);
+}
+
+bool sameCalibration(const Piston &a, const Piston &b) {
+  return a.getGeometry() == b.getGeometry() && a.getCam() == b.getCam() &&
+         a.minThrottle == b.minThrottle && a.kexpl == b.kexpl &&
+         a.thermalK == b.thermalK && a.intakeCoef == b.intakeCoef &&
+         a.exhaustCoef == b.exhaustCoef && a.ignitionOn == b.ignitionOn;
+}
+
+bool MeanValueTable::matches(const Piston &piston,
+                             const MeanValueSettings &settings) const {
+  return sameCalibration(piston, calibration) && settings == this->settings;
+}
+
+int meanValueStep(const MeanValueTable &table, Piston &piston, float deltaT,
+                  float setSpeed) {
+  const auto acceleration = [&](float omega) {
+    const float torque =
+        table.at(omega, piston.throttle, piston.combustionAdvance).torque;
+    return (torque + piston.externalTorque) /
+           piston.getGeometry().momentOfInertia;
+  };
+
+  const float omega = piston.omega;
+  float next = setSpeed;
+  if (piston.dynamicsIsActive) {
+    /* Heun: the cycle mean torque is smooth in the speed */
+    const float start = acceleration(omega);
+    const float predicted = omega + deltaT * start;
+    next = omega + deltaT / 2 * (start + acceleration(predicted));
+    /* The map has no starting, a stalled engine stays stopped */
+    next = std::max(next, 0.f);
+  }
+  piston.omega = next;
+
+  /* A step may span several cycles, the angles only matter to the eye */
+  const float head =
+      piston.headAngle + RADToDEG((omega + next) / 2) * deltaT / 2;
+  const int cycles = static_cast<int>(head / 360);
+  piston.headAngle = head - 360.f * cycles;
+  piston.currentAngle = angleWrapper(piston.headAngle * 2 + 90);
+
+  /* The gas of the old angle would not fill the chamber of the new one: the
+   * detailed model resumes from a fresh charge */
+  piston.gas = {DEFAULT_AMBIENT_PRESSURE, piston.getChamberVolume(),
+                DEFAULT_AMBIENT_TEMPERATURE, 1.f};
+  piston.V_prime = 0.f;
+  piston.combustionInProgress = false;
+  return cycles;
+}
@@ -0,0 +1,77 @@
+#ifndef MEANVALUEMODEL_HPP
+#define MEANVALUEMODEL_HPP
+#include "Sweep.hpp"
+#include <vector>
+
+/* Cycle averages of the detailed model at one operating point */
+struct MeanValuePoint {
+  float torque;             /* [Nm], friction included */
+  float airflow;            /* [kg/s] */
+  float exhaustTemperature; /* [K] */
+};
+
+/* Grid and runs of a table. The detailed model warms up until its cycles
+ * settle, which takes seven to ten at a set speed. The sweep steps as the
+ * detailed model the table stands in for: the cycle torque depends on the
+ * step, at full throttle and 175 rad/s 13.6 Nm at 10 kHz, 4.8 Nm at
+ * 100 kHz. */
+struct MeanValueSettings {
+  SweepAxis speed{20.f, 600.f, 16}; /* [rad/s] */
+  SweepAxis throttle{0.f, 1.f, 6};
+  SweepAxis advance{-20.f, 20.f, 5}; /* [deg] */
+  SweepSettings sweep{
+      .warmupCycles = 20, .stepTolerance = {}, .untilSteady = true};
+
+  bool operator==(const MeanValueSettings &) const = default;
+};
+
+/* Same geometry, cam, calibration and ignition: what a table depends on
+ * besides its settings */
+bool sameCalibration(const Piston &a, const Piston &b);
+
+/* Engine map of a calibrated piston over speed, throttle and combustion
+ * advance, at the calibrated kexpl, filled by running the detailed model to
+ * its steady cycle at every grid point. Between the points it is
+ * interpolated linearly, outside the grid held at its edge. Points the
+ * detailed model could not finish take the nearest speed that did. Only
+ * steady cycles are mapped: starting, a stall from low speed or a load
+ * that turns the crankshaft backwards are not, see the mean_value tool. */
+class MeanValueTable {
+public:
+  /* threads 0 uses all cores */
+  static MeanValueTable build(const Piston &calibration,
+                              const MeanValueSettings &settings = {},
+                              unsigned threads = 0,
+                              CycleCache *cache = nullptr);
+
+  MeanValuePoint at(float speed, float throttle, float advance) const;
+
+  /* Built for the calibration of piston, see sameCalibration(), with
+   * settings */
+  bool matches(const Piston &piston, const MeanValueSettings &settings) const;
+
+  const MeanValueSettings &getSettings() const { return settings; }
+  size_t size() const { return points.size(); }
+
+private:
+  size_t index(int s, int t, int a) const;
+
+  Piston calibration{CylinderGeometry()};
+  MeanValueSettings settings;
+  std::vector<MeanValuePoint> points; /* Throttle fastest, as SweepGrid */
+};
+
+/* Largest step of the mean-value crankshaft [s]. The speed settles with a
+ * time constant of a few tenths of a second, see the mean_value tool. */
+constexpr float MEAN_VALUE_STEP = 0.05f;
+
+/* Crankshaft of the mean-value model: only the speed is integrated, at
+ * steps of cycles rather than of degrees, under the mapped torque (Heun).
+ * Without dynamics the speed is setSpeed. The head and crank angles follow
+ * for display and the chamber is refilled with ambient air at the new angle,
+ * where the detailed model can take over. Returns the cycles the step
+ * completed, several at high speed. */
+int meanValueStep(const MeanValueTable &table, Piston &piston, float deltaT,
+                  float setSpeed);
+
+#endif
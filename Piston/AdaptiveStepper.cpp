@@ -0,0 +1,92 @@
+#include "AdaptiveStepper.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+AdaptiveStepper::AdaptiveStepper(StepTolerance tolerance)
+    : tolerance{tolerance}, nextStep{tolerance.minStep}, accepted{0},
+      rejected{0} {}
+
+float AdaptiveStepper::step(Piston &piston, float limit, float setSpeed) {
+  while (true) {
+    float h = std::min(nextStep, limit);
+    if (limit - h < tolerance.minStep) {
+      h = limit; /* Do not leave a sliver behind */
+    }
+
+    /* Land on the next event instead of stepping over it */
+    const float event = timeToNextEvent(piston);
+    if (event < h) {
+      h = std::min(std::max(event, tolerance.minStep), h);
+    }
+    const bool shortened = h < nextStep;
+
+    Piston whole = piston;
+    whole.updatePosition(h, setSpeed);
+
+    Piston half = piston;
+    half.updatePosition(h / 2, setSpeed);
+    half.updatePosition(h / 2, setSpeed);
+
+    /* The split scheme is first order: the local error of the estimate
+     * scales with h squared */
+    const float error = errorNorm(whole, half);
+    const float factor =
+        std::clamp(0.9f / std::sqrt(std::max(error, 1e-6f)), 0.2f, 5.f);
+
+    if (error <= 1.f || h <= tolerance.minStep) {
+      /* Second order from two first order solutions */
+      half.gas.Extrapolate(whole.gas);
+      if (piston.dynamicsIsActive) {
+        half.omega = 2 * half.omega - whole.omega;
+      }
+      piston = half;
+      ++accepted;
+
+      const float proposal = h * factor;
+      nextStep = shortened ? std::max(nextStep, proposal) : proposal;
+      nextStep = std::clamp(nextStep, tolerance.minStep, tolerance.maxStep);
+      return h;
+    }
+
+    ++rejected;
+    nextStep = std::max(h * factor, tolerance.minStep);
+  }
+}
+
+float AdaptiveStepper::timeToNextEvent(const Piston &piston) const {
+  const float rate = RADToDEG(piston.omega) / 2; /* Head angle [deg/s] */
+  if (rate <= 0.f) {
+    return std::numeric_limits<float>::infinity();
+  }
+
+  /* TDC and BDC every 90 head degrees, then the spark */
+  const float head = piston.headAngle;
+  float next = (std::floor(head / 90.f) + 1.f) * 90.f;
+  if (piston.ignitionOn) {
+    float spark = piston.combustionAdvance + 180.f;
+    while (spark <= head) {
+      spark += 360.f;
+    }
+    while (spark - 360.f > head) {
+      spark -= 360.f;
+    }
+    next = std::min(next, spark);
+  }
+  return (next - head) / rate;
+}
+
+float AdaptiveStepper::errorNorm(const Piston &a, const Piston &b) const {
+  /* Relative difference, with a floor for quantities crossing zero */
+  const auto relative = [&](float x, float y, float scale) {
+    const float size = std::max({std::fabs(x), std::fabs(y), scale});
+    return std::fabs(x - y) / (tolerance.relative * size);
+  };
+
+  return std::max(
+      {relative(a.gas.getP(), b.gas.getP(), DEFAULT_AMBIENT_PRESSURE),
+       relative(a.gas.getT(), b.gas.getT(), DEFAULT_AMBIENT_TEMPERATURE),
+       relative(a.gas.getnR(), b.gas.getnR(), 0.f),
+       relative(a.omega, b.omega, 1.f),
+       std::fabs(a.gas.getOx() - b.gas.getOx()) / tolerance.oxygen});
+}
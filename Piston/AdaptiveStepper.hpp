@@ -0,0 +1,49 @@
+#ifndef ADAPTIVESTEPPER_HPP
+#define ADAPTIVESTEPPER_HPP
+#include "Piston.hpp"
+#include <cstdint>
+
+struct StepTolerance {
+  float relative = 1e-2f; /* On pressure, temperature, charge and speed */
+  float oxygen = 1e-3f;   /* Absolute, on the oxygen fraction */
+  float minStep = 1e-6f;  /* [s] */
+  float maxStep = 1e-3f;  /* [s] */
+
+  bool operator==(const StepTolerance &) const = default;
+};
+
+/* Error controlled, variable step integration of a Piston. Every step is
+ * taken whole and as two halves: their difference estimates the local error
+ * and their Richardson extrapolation is kept. Steps are cut to end on TDC,
+ * BDC and the spark, so event timing no longer depends on the step size. */
+class AdaptiveStepper {
+public:
+  AdaptiveStepper(StepTolerance tolerance = {});
+
+  /* Advances the piston by duration, calling onStep(dt) after every step */
+  template <typename F>
+  void advance(Piston &piston, double duration, float setSpeed, F &&onStep) {
+    double remaining = duration;
+    while (remaining > 0.0) {
+      const float dt = step(piston, static_cast<float>(remaining), setSpeed);
+      remaining -= dt;
+      onStep(dt);
+    }
+  }
+
+  /* Takes one accepted step of at most limit, returns its size */
+  float step(Piston &piston, float limit, float setSpeed);
+
+  StepTolerance tolerance;
+  float nextStep; /* Proposed size of the next step [s] */
+
+  /* Statistics */
+  uint64_t accepted;
+  uint64_t rejected;
+
+private:
+  float timeToNextEvent(const Piston &piston) const;
+  float errorNorm(const Piston &a, const Piston &b) const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include "CrankTables.hpp"
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+constexpr double STEP = 360.0 / CrankTables::SIZE; /* [deg] */
+constexpr double RAD = std::numbers::pi / 180.0;
+
+template <typename T>
+const BasicCrankTables<T> *
+BasicCrankTables<T>::lookup(const CylinderGeometry &geometry,
+                            const CamProfile &cam) {
+  static std::mutex mutex;
+  static std::vector<std::unique_ptr<const BasicCrankTables>> cache;
+
+  std::lock_guard lock(mutex);
+  for (const auto &tables : cache) {
+    if (tables->geometry == geometry && tables->cam == cam) {
+      return tables.get();
+    }
+  }
+  cache.push_back(std::make_unique<const BasicCrankTables>(geometry, cam));
+  return cache.back().get();
+}
+
+template <typename T>
+template <typename F>
+void BasicCrankTables<T>::hermite(Table &table, F f) {
+  for (int i = 0; i < SIZE; ++i) {
+    const auto [v0, d0] = f(i * STEP);
+    const auto [v1, d1] = f((i + 1) * STEP);
+    const double m0 = d0 * STEP;
+    const double m1 = d1 * STEP;
+    table[i] = {static_cast<T>(v0), static_cast<T>(m0),
+                static_cast<T>(3 * (v1 - v0) - 2 * m0 - m1),
+                static_cast<T>(2 * (v0 - v1) + m0 + m1)};
+  }
+}
+
+template <typename T>
+template <typename F>
+void BasicCrankTables<T>::linear(Table &table, F f) {
+  for (int i = 0; i < SIZE; ++i) {
+    const double v0 = f(i * STEP);
+    const double v1 = f((i + 1) * STEP);
+    table[i] = {static_cast<T>(v0), static_cast<T>(v1 - v0), 0, 0};
+  }
+}
+
+template <typename T>
+BasicCrankTables<T>::BasicCrankTables(const CylinderGeometry &geometry,
+                                      const CamProfile &cam)
+    : geometry{geometry}, cam{cam} {
+  const double r = geometry.stroke / 2.0;
+  const double rod = geometry.rod;
+
+  /* Piston position, as in the original closed form */
+  hermite(positionTable, [&](double angle) {
+    const double s = std::sin(angle * RAD);
+    const double c = std::cos(angle * RAD);
+    const double root = std::sqrt(1 - r * r * c * c / (rod * rod));
+    const double position = -r * s - rod * root;
+    const double slope = -r * c - r * r * c * s / (rod * root);
+    return std::pair{position, slope * RAD};
+  });
+
+  /* Rod angle and lever arm are only used for the torque */
+  linear(rodAngleTable, [&](double angle) {
+    return std::asin(r / rod * std::cos(angle * RAD));
+  });
+  linear(leverArmTable, [&](double angle) {
+    return r * std::cos(std::asin(r / rod * std::cos(angle * RAD)));
+  });
+
+  /* Gaussian lobes over the revolution centred on the lobe */
+  const auto lobe = [](double center, double width) {
+    return [=](double angle) {
+      double x = std::fmod(angle - center + 180.0, 360.0);
+      x = ((x < 0) ? x + 180.0 : x - 180.0) / width;
+      const double lift = std::exp(-x * x);
+      return std::pair{lift, -2 * x * lift / width};
+    };
+  };
+  hermite(intakeTable, lobe(cam.intakeCenter, cam.intakeWidth));
+  hermite(exhaustTable, lobe(cam.exhaustCenter, cam.exhaustWidth));
+}
+
+template class BasicCrankTables<float>;
+template class BasicCrankTables<double>;
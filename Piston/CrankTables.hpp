@@ -0,0 +1,78 @@
+#ifndef CRANKTABLES_HPP
+#define CRANKTABLES_HPP
+#include "Piston.hpp"
+#include <array>
+
+/* Geometry and valve lift of a cylinder tabulated over one revolution, so
+ * stepping costs a table lookup and a few FMAs instead of trigonometry.
+ * Smooth quantities are stored as cubic Hermite segments built from their
+ * analytic derivative: the interpolant and its slope are continuous, which
+ * keeps the finite difference volume rate of the gas model accurate. T is
+ * the scalar type of the pistons reading them: the segments are built in
+ * double and stored in T. */
+template <typename T> class BasicCrankTables {
+public:
+  static constexpr int SIZE = 720; /* Segments per revolution */
+
+  /* Tables are immutable and shared by all the pistons with the same
+   * geometry and cam profile; they live until the program exits */
+  static const BasicCrankTables *lookup(const CylinderGeometry &geometry,
+                                        const CamProfile &cam);
+
+  BasicCrankTables(const CylinderGeometry &geometry, const CamProfile &cam);
+
+  /* Crank angle [deg] in [0, 360] */
+  T position(T crankAngle) const {
+    return evaluate(positionTable, crankAngle);
+  }
+  T rodAngle(T crankAngle) const { /* [rad] */
+    return evaluate(rodAngleTable, crankAngle);
+  }
+  T leverArm(T crankAngle) const { /* Stroke/2 cos(rod angle) [m] */
+    return evaluate(leverArmTable, crankAngle);
+  }
+
+  /* Head angle [deg] in [0, 360] */
+  T intakeLift(T headAngle) const {
+    return evaluate(intakeTable, headAngle);
+  }
+  T exhaustLift(T headAngle) const {
+    return evaluate(exhaustTable, headAngle);
+  }
+
+  const CylinderGeometry geometry;
+  const CamProfile cam;
+
+private:
+  /* a + t (b + t (c + t d)), t in [0, 1] across the segment */
+  struct Segment {
+    T a, b, c, d;
+  };
+  using Table = std::array<Segment, SIZE>;
+
+  static T evaluate(const Table &table, T angle) {
+    const T x = angle * (SIZE / T(360));
+    int i = static_cast<int>(x);
+    i = (i < 0) ? 0 : (i >= SIZE) ? SIZE - 1 : i;
+    const T t = x - i;
+    const Segment &s = table[i];
+    return s.a + t * (s.b + t * (s.c + t * s.d));
+  }
+
+  /* f(angle) returns the value and the derivative per degree */
+  template <typename F> static void hermite(Table &table, F f);
+  template <typename F> static void linear(Table &table, F f);
+
+  Table positionTable;
+  Table rodAngleTable;
+  Table leverArmTable;
+  Table intakeTable;
+  Table exhaustTable;
+};
+
+extern template class BasicCrankTables<float>;
+extern template class BasicCrankTables<double>;
+
+using CrankTables = BasicCrankTables<float>;
+
+#endif
@@ -0,0 +1,79 @@
+#include "CycleStats.hpp"
+#include <cmath>
+
+double RunningStat::cov() const {
+  return (count > 1 && mean != 0.0) ? std::sqrt(variance()) / std::fabs(mean)
+                                    : 0.0;
+}
+
+void CycleStats::update(const Piston &piston, float torque, float deltaT) {
+  const float p = piston.gas.getP();
+  const float v = piston.gas.getV();
+
+  work += static_cast<double>(torque) * deltaT;
+  torqueSq += static_cast<double>(torque) * torque * deltaT;
+  heat += piston.heatRelease;
+  time += deltaT;
+  ++steps;
+
+  /* Trapezoidal ∮ p dV */
+  if (primed) {
+    gasWork += 0.5 * (static_cast<double>(p) + previousP) * (v - previousV);
+
+    if (previousHead < 180.f && piston.headAngle >= 180.f) {
+      trappedMass = NRToKG(piston.gas.getnR());
+    }
+  }
+
+  if (p > peakPressure) {
+    peakPressure = p;
+    peakAngle = 2 * piston.headAngle;
+  }
+
+  primed = true;
+  previousP = p;
+  previousV = v;
+  previousHead = piston.headAngle;
+  displacement = piston.getEngineVolume();
+  oxygen = piston.gas.getOx();
+}
+
+void CycleStats::endCycle() {
+  CycleSummary &s = published.last;
+  s.torque = (time > 0) ? work / time : 0.f;
+  s.torqueRms = (time > 0) ? std::sqrt(torqueSq / time) : 0.f;
+  s.imep = (displacement > 0) ? gasWork / displacement : 0.f;
+  s.peakPressure = peakPressure;
+  s.peakPressureAngle = peakAngle;
+  s.trappedMass = trappedMass;
+  s.residualOxygen = oxygen;
+  s.heatRelease = heat;
+  s.duration = time;
+  s.steps = steps;
+  s.complete = complete;
+  ++published.cycles;
+
+  if (complete) {
+    published.torque.add(s.torque);
+    published.imep.add(s.imep);
+    published.peakPressure.add(s.peakPressure);
+  }
+
+  complete = true;
+  work = 0.0;
+  torqueSq = 0.0;
+  gasWork = 0.0;
+  heat = 0.0;
+  time = 0.0;
+  steps = 0;
+  peakPressure = 0.f;
+  peakAngle = 0.f;
+  trappedMass = 0.f;
+}
+
+void CycleStats::restart() {
+  complete = false;
+  published.torque = {};
+  published.imep = {};
+  published.peakPressure = {};
+}
@@ -0,0 +1,103 @@
+#ifndef CYCLESTATS_HPP
+#define CYCLESTATS_HPP
+#include "Piston.hpp"
+#include <cstdint>
+
+/* Metrics of one complete engine cycle */
+struct CycleSummary {
+  float torque;            /* Time weighted mean [Nm] */
+  float torqueRms;         /* [Nm] */
+  float imep;              /* Indicated mean effective pressure [Pa] */
+  float peakPressure;      /* [Pa] */
+  float peakPressureAngle; /* Crank angle from the cycle start [deg] */
+  float trappedMass;       /* At firing TDC [kg] */
+  float residualOxygen;    /* At the cycle end [0, 1] */
+  float heatRelease;       /* [J] */
+  float duration;          /* [s] */
+  uint64_t steps;
+  bool complete; /* False for a cycle observed from the middle */
+};
+
+/* Running mean and variance of a metric over cycles (Welford) */
+struct RunningStat {
+  uint64_t count = 0;
+  double mean = 0.0;
+  double m2 = 0.0; /* Sum of squared deviations from the mean */
+
+  void add(double x) {
+    ++count;
+    const double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+  }
+  double variance() const { return (count > 1) ? m2 / (count - 1) : 0.0; }
+  /* Coefficient of variation, standard deviation over the mean */
+  double cov() const;
+};
+
+/* Published once per cycle */
+struct CycleReport {
+  CycleSummary last{};
+  uint64_t cycles = 0; /* Cycles ended, complete or not */
+
+  /* Cycle to cycle spread over the complete cycles since the last restart */
+  RunningStat torque;
+  RunningStat imep;
+  RunningStat peakPressure;
+};
+
+/* Accumulates the cycle metrics step by step in O(1), so that nothing has
+ * to keep or scan the raw traces. update() after every step, endCycle()
+ * when the piston raises cycleTrigger. */
+class CycleStats {
+public:
+  /* torque is the crank torque after the step, usually already computed */
+  void update(const Piston &piston, float torque, float deltaT);
+  void endCycle();
+
+  /* The cycle in progress is incomplete and the spread starts over, e.g.
+   * after the operating point changed */
+  void restart();
+
+  const CycleReport &report() const { return published; }
+
+  /* Passes every state member to archive(...), e.g. for checkpoints */
+  template <typename Archive> void serialize(Archive &archive) {
+    CycleSummary &s = published.last;
+    archive(s.torque, s.torqueRms, s.imep, s.peakPressure, s.peakPressureAngle,
+            s.trappedMass, s.residualOxygen, s.heatRelease, s.duration,
+            s.steps, s.complete, published.cycles);
+    for (RunningStat *r :
+         {&published.torque, &published.imep, &published.peakPressure}) {
+      archive(r->count, r->mean, r->m2);
+    }
+    archive(complete, work, torqueSq, gasWork, heat, time, steps, peakPressure,
+            peakAngle, trappedMass, primed, previousP, previousV, previousHead,
+            displacement, oxygen);
+  }
+
+private:
+  CycleReport published;
+
+  /* Cycle in progress */
+  bool complete = false;
+  double work = 0.0;       /* Crank side, ∫ torque dt [J] */
+  double torqueSq = 0.0;   /* ∫ torque² dt */
+  double gasWork = 0.0;    /* Gas side, ∮ p dV [J] */
+  double heat = 0.0;
+  double time = 0.0;
+  uint64_t steps = 0;
+  float peakPressure = 0.f;
+  float peakAngle = 0.f;
+  float trappedMass = 0.f;
+
+  /* Previous step */
+  bool primed = false;
+  float previousP = 0.f;
+  float previousV = 0.f;
+  float previousHead = 0.f;
+  float displacement = 0.f;
+  float oxygen = 0.f;
+};
+
+#endif
@@ -2,19 +2,41 @@
 #define PISTON_HPP
 #include "IdealGas.hpp"
 #include "Linalg.hpp"
+#include <concepts>
 #include <numbers>
 #include <stdio.h>
 
-constexpr float DEGToRAD(float X) {
-  return (2.0 * std::numbers::pi * (X) / 360.0);
+template <std::floating_point T> constexpr T DEGToRAD(T X) {
+  return (2 * std::numbers::pi_v<T> * (X) / 360);
 }
-constexpr float RADToDEG(float X) {
-  return (360.0 * (X) / (2 * std::numbers::pi));
+template <std::floating_point T> constexpr T RADToDEG(T X) {
+  return (360 * (X) / (2 * std::numbers::pi_v<T>));
+}
+template <std::floating_point T> constexpr T RADSToHZ(T X) {
+  return ((X) / (2 * std::numbers::pi_v<T>));
+}
+template <std::floating_point T> constexpr T RADSToRPM(T X) {
+  return (60 * RADSToHZ((X)));
+}
+template <std::floating_point T> constexpr T M3ToCC(T X) {
+  return (1000000 * (X));
+}
+template <std::floating_point T> constexpr T MMToM(T X) {
+  return ((X) / 1000);
+}
+
+/* Step at which kexpl, the oxygen fraction burnt per step, is calibrated */
+constexpr float COMBUSTION_REFERENCE_STEP = 1e-4f; /* [s] */
+
+template <std::floating_point T> inline T angleWrapper(T angle) {
+  while (angle > 360) {
+    angle -= 360;
+  }
+  while (angle < 0) {
+    angle += 360;
+  }
+  return angle;
 }
-constexpr float RADSToHZ(float X) { return ((X) / (2 * std::numbers::pi)); }
-constexpr float RADSToRPM(float X) { return (60.0 * RADSToHZ((X))); }
-constexpr float M3ToCC(float X) { return (1000000 * (X)); }
-constexpr float MMToM(float X) { return ((X) / 1000.0); }
 
 class CylinderGeometry {
 public:
@@ -24,62 +46,89 @@ public:
   float stroke;
   float addStroke;
   float momentOfInertia;
+
+  bool operator==(const CylinderGeometry &) const = default;
 };
 
-class Piston {
+/* Gaussian valve lift laws, centre and width in head crank degrees */
+struct CamProfile {
+  float intakeCenter = 45.f;
+  float intakeWidth = 30.f;
+  float exhaustCenter = 315.f;
+  float exhaustWidth = 20.f;
+
+  bool operator==(const CamProfile &) const = default;
+};
+
+template <typename T> class BasicCrankTables;
+
+/* T is the scalar type of the state, float for bulk runs and double for
+ * reference ones; Math is the precision policy of the gas model, see
+ * GasMath.hpp */
+template <typename T, typename Math = ExactMath> class BasicPiston {
 public:
-  Piston(CylinderGeometry geometryInfo);
+  BasicPiston(CylinderGeometry geometryInfo, T initialHeadAngle = 0);
 
   /* Internal Clock */
-  float internalTime;
+  T internalTime;
 
-  /* Specs */
-  CylinderGeometry geometry;
-  vector2_T rodFoot;
+  /* Specs, written only through setGeometry/setCam, which rebuild the
+   * tables */
+  const CylinderGeometry &getGeometry() const { return geometry; }
+  const CamProfile &getCam() const { return cam; }
+  const BasicCrankTables<T> *tables;
+  void setGeometry(const CylinderGeometry &geometryInfo);
+  void setCam(const CamProfile &profile);
 
-  float throttle;
-  float minThrottle;
+  T throttle;
+  T minThrottle;
 
   /* Dynamics */
   bool ignitionOn;
-  float omega;
-  float headAngle;
-  float currentAngle;
-  void updatePosition(float deltaT, float setSpeed);
-  void updateStatus(float deltaT);
+  T omega;
+  T headAngle;
+  T currentAngle;
+  void updatePosition(T deltaT, T setSpeed);
+  void followCrank(T crankHeadAngle, T crankOmega, T deltaT);
+  void updateKinematics(T deltaT);
+  void updateTriggers(T previousHeadAngle);
+  void updateStatus(T deltaT);
   void ValveMgm();
-  void applyExtTorque(float torque);
-  float externalTorque;
+  void applyExtTorque(T torque);
+  T externalTorque;
 
-  float combustionAdvance;
+  T combustionAdvance;
 
   /* Generic Methods */
-  float getPistonPosition();
-  float getCyclePercent();
-  float getChamberVolume();
-  float getMaxVolume();
-  float getEngineVolume();
-  float getCompressionRatio();
-  float getThetaAngle();
-  float getTorque();
-  constexpr float getThrottle(float curr);
+  T getPistonPosition() const;
+  T getCyclePercent() const;
+  T getChamberVolume() const;
+  T getMaxVolume() const;
+  T getEngineVolume() const;
+  T getCompressionRatio() const;
+  T getThetaAngle() const;
+  T getTorque() const;
+  constexpr T getThrottle(T curr) const {
+    return (1 - minThrottle) * curr + minThrottle;
+  }
 
   /* Thermodynamics */
-  float V_prime;
-  Gas *gas;
+  T V_prime;
+  BasicGas<T, Math> gas;
   bool combustionInProgress;
-  float kexpl;
+  T heatRelease; /* Heat injected at the last step [J] */
+  T kexpl;
 
   /* Valves */
-  float intakeValve;
-  float exhaustValve;
-  float intakeFlow;
-  float exhaustFlow;
-  float leakageFlow;
-  float intakeCoef;
-  float exhaustCoef;
+  T intakeValve;
+  T exhaustValve;
+  T intakeFlow;
+  T exhaustFlow;
+  T leakageFlow;
+  T intakeCoef;
+  T exhaustCoef;
 
-  float thermalK;
+  T thermalK;
 
   /* Settings */
   bool dynamicsIsActive;
@@ -88,6 +137,14 @@ public:
   bool cycleTrigger;
 
 private:
+  CylinderGeometry geometry;
+  CamProfile cam;
 };
 
+extern template class BasicPiston<float, ExactMath>;
+extern template class BasicPiston<float, FastMath>;
+extern template class BasicPiston<double, ExactMath>;
+
+using Piston = BasicPiston<float>;
+
 #endif
@@ -0,0 +1,4 @@
+#include "PistonImpl.hpp"
+
+/* Compiled for the host CPU where the build allows, see CMakeLists.txt */
+template class BasicPiston<float, FastMath>;
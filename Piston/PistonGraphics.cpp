@@ -1,35 +1,39 @@
 #include "PistonGraphics.hpp"
+#include <cmath>
 
-PistonGraphics::PistonGraphics(vector2_T pos, Piston *piston,
+PistonGraphics::PistonGraphics(vector2_T pos, const Piston *piston,
                                int rescaleFactor) {
   this->crankCenter = pos;
   this->piston = piston;
   this->rescaleFactor = rescaleFactor;
+  const CylinderGeometry &geometry = piston->getGeometry();
 
   /* Cylinder walls position */
   this->cilinderRectPos = pos;
-  this->cilinderRectPos.y -= rescaleFactor * piston->geometry.rod +
-                             rescaleFactor * piston->geometry.stroke / 2;
+  this->cilinderRectPos.y -=
+      rescaleFactor * geometry.rod + rescaleFactor * geometry.stroke / 2;
 }
 
 float PistonGraphics::getPistonPosition() {
+  const CylinderGeometry &geometry = piston->getGeometry();
   const float a = rodFoot.y;
-  const float b = (rescaleFactor * piston->geometry.stroke / 2) *
-                  (rescaleFactor * piston->geometry.stroke / 2) *
+  const float b = (rescaleFactor * geometry.stroke / 2) *
+                  (rescaleFactor * geometry.stroke / 2) *
                   cosf(DEGToRAD(piston->currentAngle)) *
                   cosf(DEGToRAD(piston->currentAngle));
-  const float c = b / (rescaleFactor * piston->geometry.rod * rescaleFactor *
-                       piston->geometry.rod);
-  const float d = rescaleFactor * piston->geometry.rod * sqrtf(1 - c);
+  const float c =
+      b / (rescaleFactor * geometry.rod * rescaleFactor * geometry.rod);
+  const float d = rescaleFactor * geometry.rod * sqrtf(1 - c);
   return a - d;
 }
 
 void PistonGraphics::showPiston(SDL_Renderer *renderer) {
+  const CylinderGeometry &geometry = piston->getGeometry();
   /* Update engine geometry */
   rodFoot = {
-      .x = crankCenter.x + (rescaleFactor * piston->geometry.stroke / 2) *
+      .x = crankCenter.x + (rescaleFactor * geometry.stroke / 2) *
                                cosf(DEGToRAD(piston->currentAngle)),
-      .y = crankCenter.y - (rescaleFactor * piston->geometry.stroke / 2) *
+      .y = crankCenter.y - (rescaleFactor * geometry.stroke / 2) *
                                sinf(DEGToRAD(piston->currentAngle))};
 
   pistonPos = {.x = crankCenter.x, .y = getPistonPosition()};
@@ -37,11 +41,9 @@ void PistonGraphics::showPiston(SDL_Renderer *renderer) {
   /* Combustion */
   if (piston->ignitionOn) {
     SDL_Rect combustion;
-    combustion.x =
-        cilinderRectPos.x - rescaleFactor * piston->geometry.bore / 2;
-    combustion.y =
-        cilinderRectPos.y - piston->geometry.addStroke * rescaleFactor + 2;
-    combustion.w = rescaleFactor * piston->geometry.bore;
+    combustion.x = cilinderRectPos.x - rescaleFactor * geometry.bore / 2;
+    combustion.y = cilinderRectPos.y - geometry.addStroke * rescaleFactor + 2;
+    combustion.w = rescaleFactor * geometry.bore;
     combustion.h = -combustion.y + pistonPos.y;
     SDL_SetRenderDrawColor(renderer, 64, 32, 0, 0);
     if (piston->headAngle >= 180 - piston->combustionAdvance) {
@@ -57,13 +59,13 @@ void PistonGraphics::showPiston(SDL_Renderer *renderer) {
   /* Draw the cylinder */
   SDL_Rect cylinder;
   SDL_Rect addStroke;
-  cylinder.x = cilinderRectPos.x - rescaleFactor * piston->geometry.bore / 2;
+  cylinder.x = cilinderRectPos.x - rescaleFactor * geometry.bore / 2;
   cylinder.y = cilinderRectPos.y;
-  cylinder.h = rescaleFactor * piston->geometry.stroke;
-  cylinder.w = rescaleFactor * piston->geometry.bore;
+  cylinder.h = rescaleFactor * geometry.stroke;
+  cylinder.w = rescaleFactor * geometry.bore;
   addStroke.x = cylinder.x;
-  addStroke.y = cylinder.y - piston->geometry.addStroke * rescaleFactor + 2;
-  addStroke.h = piston->geometry.addStroke * rescaleFactor;
+  addStroke.y = cylinder.y - geometry.addStroke * rescaleFactor + 2;
+  addStroke.h = geometry.addStroke * rescaleFactor;
   addStroke.w = cylinder.w;
   SDL_RenderDrawRect(renderer, &cylinder);
   SDL_RenderDrawRect(renderer, &addStroke);
@@ -71,34 +73,47 @@ void PistonGraphics::showPiston(SDL_Renderer *renderer) {
   SDL_SetRenderDrawColor(renderer, 255, 0, 0, 0);
   SDL_RenderDrawLine(renderer, rodFoot.x, rodFoot.y, pistonPos.x, pistonPos.y);
   SDL_RenderDrawLine(
-      renderer, pistonPos.x - rescaleFactor * piston->geometry.bore / 2,
-      pistonPos.y, pistonPos.x + rescaleFactor * piston->geometry.bore / 2,
+      renderer, pistonPos.x - rescaleFactor * geometry.bore / 2,
+      pistonPos.y, pistonPos.x + rescaleFactor * geometry.bore / 2,
       pistonPos.y);
 
   /* Draw Intake Valve */
   SDL_SetRenderDrawColor(renderer, 255, 255, 255, 0);
   const int intakeValveH = piston->intakeValve * 10;
   SDL_RenderDrawLine(renderer,
-                     addStroke.x + rescaleFactor * piston->geometry.bore / 4,
+                     addStroke.x + rescaleFactor * geometry.bore / 4,
                      addStroke.y + intakeValveH,
-                     addStroke.x + rescaleFactor * piston->geometry.bore / 4,
+                     addStroke.x + rescaleFactor * geometry.bore / 4,
                      addStroke.y - 50 + intakeValveH);
   SDL_RenderDrawLine(
-      renderer, addStroke.x + rescaleFactor * piston->geometry.bore / 4 - 10,
+      renderer, addStroke.x + rescaleFactor * geometry.bore / 4 - 10,
       addStroke.y + intakeValveH,
-      addStroke.x + rescaleFactor * piston->geometry.bore / 4 + 10,
+      addStroke.x + rescaleFactor * geometry.bore / 4 + 10,
       addStroke.y + intakeValveH);
 
   const int exhaustValveH = piston->exhaustValve * 10;
   SDL_RenderDrawLine(
-      renderer, addStroke.x + 3 * rescaleFactor * piston->geometry.bore / 4,
+      renderer, addStroke.x + 3 * rescaleFactor * geometry.bore / 4,
       addStroke.y + exhaustValveH,
-      addStroke.x + 3 * rescaleFactor * piston->geometry.bore / 4,
+      addStroke.x + 3 * rescaleFactor * geometry.bore / 4,
       addStroke.y - 50 + exhaustValveH);
   SDL_RenderDrawLine(
-      renderer,
-      addStroke.x + 3 * rescaleFactor * piston->geometry.bore / 4 - 10,
+      renderer, addStroke.x + 3 * rescaleFactor * geometry.bore / 4 - 10,
       addStroke.y + exhaustValveH,
-      addStroke.x + 3 * rescaleFactor * piston->geometry.bore / 4 + 10,
+      addStroke.x + 3 * rescaleFactor * geometry.bore / 4 + 10,
       addStroke.y + exhaustValveH);
-}
\ No newline at end of file
+}
+
+Piston interpolatePiston(const Piston &from, const Piston &to, float dt,
+                         float alpha) {
+  /* Head crank turn, the nearest to what the speed predicts */
+  const float expected = RADToDEG(from.omega + to.omega) / 2 * dt / 2;
+  float turn = to.headAngle - from.headAngle;
+  turn += 360.f * std::round((expected - turn) / 360.f);
+
+  Piston piston = to;
+  piston.headAngle = angleWrapper(from.headAngle + alpha * turn);
+  piston.currentAngle = angleWrapper(piston.headAngle * 2 + 90);
+  piston.omega = from.omega + alpha * (to.omega - from.omega);
+  return piston;
+}
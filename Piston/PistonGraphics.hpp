@@ -7,11 +7,11 @@
 
 class PistonGraphics {
 public:
-  PistonGraphics(vector2_T pos, Piston *piston, int rescaleFactor);
+  PistonGraphics(vector2_T pos, const Piston *piston, int rescaleFactor);
   void showPiston(SDL_Renderer *renderer);
   float getPistonPosition();
 
-  Piston *piston;
+  const Piston *piston;
 
   /* GGeometry */
   vector2_T crankCenter;
@@ -22,4 +22,10 @@ public:
   int rescaleFactor;
 };
 
+/* State to draw at alpha in [0, 1] of the way from one published piston to
+ * the next, dt apart [s]. The crank may turn by most of a revolution in
+ * between: the turn is unwrapped along the mean speed. */
+Piston interpolatePiston(const Piston &from, const Piston &to, float dt,
+                         float alpha);
+
 #endif
@@ -0,0 +1,207 @@
+#ifndef PISTONIMPL_HPP
+#define PISTONIMPL_HPP
+#include "Piston.hpp"
+#include "CrankTables.hpp"
+#include <cmath>
+#include <numbers>
+
+/* Member definitions of the piston, for the translation units that
+ * instantiate it: Piston.cpp and PistonFastMath.cpp */
+
+template <typename T, typename Math>
+BasicPiston<T, Math>::BasicPiston(CylinderGeometry geometryInfo,
+                                  T initialHeadAngle)
+    : internalTime{}, omega{}, headAngle{initialHeadAngle}, externalTorque{},
+      V_prime{}, intakeValve{}, exhaustValve{}, intakeFlow{}, exhaustFlow{},
+      leakageFlow{} {
+  /* Piston Geometry */
+  this->geometry = geometryInfo;
+  tables = BasicCrankTables<T>::lookup(geometry, cam);
+
+  /* Dynamics */
+  currentAngle = angleWrapper(headAngle * 2 + 90); /* Deg */
+
+  minThrottle = 0.075f;
+  throttle = 0.f;
+
+  ignitionOn = false;
+  combustionInProgress = false;
+  heatRelease = 0.f;
+  combustionAdvance = 0.f;
+  kexpl = 0.07f;
+
+  // Calibrations
+  thermalK = 0.5f;
+
+  // Valves
+  intakeCoef = 0.0006f;
+  exhaustCoef = 0.0004f;
+
+  /* Thermodynamics */
+  gas = BasicGas<T, Math>(DEFAULT_AMBIENT_PRESSURE, getChamberVolume(), 300, 1);
+
+  dynamicsIsActive = true;
+  cycleTrigger = false;
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::updatePosition(T deltaT, T setSpeed) {
+  const T previousHeadAngle = headAngle;
+  headAngle +=
+      RADToDEG(omega) * deltaT / 2; /* Head crank rotates at half the speed */
+
+  updateKinematics(deltaT);
+
+  if (this->dynamicsIsActive) {
+    omega += deltaT * (getTorque() + externalTorque) / geometry.momentOfInertia;
+  } else {
+    omega = setSpeed;
+  }
+
+  updateTriggers(previousHeadAngle);
+  updateStatus(deltaT);
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::followCrank(T crankHeadAngle, T crankOmega,
+                                       T deltaT) {
+  const T previousHeadAngle = headAngle;
+  headAngle = crankHeadAngle;
+  omega = crankOmega;
+
+  updateKinematics(deltaT);
+  updateTriggers(previousHeadAngle);
+  updateStatus(deltaT);
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::updateKinematics(T deltaT) {
+  /* Volume at the previous crank position */
+  const T prevV = getChamberVolume();
+
+  currentAngle = headAngle * 2 + 90;
+
+  /* Angle Wrapping */
+  currentAngle = angleWrapper(currentAngle);
+  headAngle = angleWrapper(headAngle);
+
+  V_prime = (getChamberVolume() - prevV) / deltaT;
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::updateTriggers(T previousHeadAngle) {
+  /* Check if the spark plug has triggered */
+  if (ignitionOn && previousHeadAngle < combustionAdvance + 180 &&
+      headAngle >= combustionAdvance + 180) {
+    combustionInProgress = true;
+  }
+
+  /* A full cycle of the engine has terminated */
+  if (previousHeadAngle > headAngle) {
+    cycleTrigger = true;
+    combustionInProgress = false;
+  }
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::updateStatus(T deltaT) {
+  /* Valve Status Update */
+  ValveMgm();
+
+  /* Thermodynamics */
+  gas.AdiabaticCompress(V_prime, deltaT);
+  intakeFlow = gas.SimpleFlow(getThrottle(throttle) * intakeCoef * intakeValve,
+                              DEFAULT_AMBIENT_PRESSURE,
+                              DEFAULT_AMBIENT_TEMPERATURE, 1, deltaT);
+  exhaustFlow =
+      gas.SimpleFlow(exhaustCoef * exhaustValve, DEFAULT_AMBIENT_PRESSURE,
+                     DEFAULT_AMBIENT_TEMPERATURE, 0, deltaT);
+  gas.HeatExchange(thermalK, DEFAULT_AMBIENT_TEMPERATURE, deltaT);
+
+  /* Same burn rate whatever the step size */
+  if (combustionInProgress) {
+    const T kx = 1 - Math::pow(1 - kexpl, deltaT / COMBUSTION_REFERENCE_STEP);
+    heatRelease = gas.InjectHeat(kx, deltaT);
+  } else {
+    heatRelease = 0;
+  }
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::applyExtTorque(T torque) { externalTorque = torque; }
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::setGeometry(const CylinderGeometry &geometryInfo) {
+  geometry = geometryInfo;
+  tables = BasicCrankTables<T>::lookup(geometry, cam);
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::setCam(const CamProfile &profile) {
+  cam = profile;
+  tables = BasicCrankTables<T>::lookup(geometry, cam);
+}
+
+template <typename T, typename Math>
+void BasicPiston<T, Math>::ValveMgm() {
+  intakeValve = tables->intakeLift(headAngle);
+  exhaustValve = tables->exhaustLift(headAngle);
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getPistonPosition() const {
+  return tables->position(currentAngle);
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getCyclePercent() const {
+  return (-getPistonPosition() - geometry.rod + geometry.stroke / 2) /
+         (geometry.stroke);
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getChamberVolume() const {
+  const T constantVol = geometry.bore * geometry.bore *
+                        std::numbers::pi_v<T> * geometry.addStroke / 4;
+  return (1 - getCyclePercent()) * std::numbers::pi_v<T> * geometry.bore *
+             geometry.bore * geometry.stroke / 4 +
+         constantVol;
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getMaxVolume() const {
+  return std::numbers::pi_v<T> * (geometry.bore) * (geometry.bore) *
+         (geometry.addStroke + geometry.stroke) / 4;
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getEngineVolume() const {
+  return std::numbers::pi_v<T> * (geometry.bore) * (geometry.bore) *
+         (geometry.stroke) / 4;
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getCompressionRatio() const {
+  return getMaxVolume() / (geometry.bore * geometry.bore *
+                           std::numbers::pi_v<T> * geometry.addStroke / 4);
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getThetaAngle() const {
+  return tables->rodAngle(currentAngle);
+}
+
+template <typename T, typename Math>
+T BasicPiston<T, Math>::getTorque() const {
+  const T pistonSurface =
+      (geometry.bore * geometry.bore * std::numbers::pi_v<T> / 4);
+  const T topPistonPressure = gas.getP(); // thermo.gas.P;
+  const T absTorque = pistonSurface * (topPistonPressure - 101325) *
+                      tables->leverArm(currentAngle);
+
+  const T friction = -omega * 0.05f;
+
+  return (getThetaAngle() < 0) ? absTorque + friction : -absTorque + friction;
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "SteadyState.hpp"
+#include <algorithm>
+#include <cmath>
+
+/* Scale a component is resolved at */
+static float scale(int component, float value) {
+  constexpr float floors[CycleState::SIZE] = {1.f, 0.f, 1.f, 1.f};
+  return std::max(std::fabs(value), floors[component]);
+}
+
+CycleState CycleState::of(const Piston &piston) {
+  return CycleState{{piston.omega, piston.gas.getnR(), piston.gas.getT(),
+                     piston.gas.getOx()}};
+}
+
+void CycleState::moveTo(const CycleState &target, Piston &piston) const {
+  const float volume = piston.gas.getV();
+  const float nR = piston.gas.getnR() + target.values[1] - values[1];
+  const float temperature = piston.gas.getT() + target.values[2] - values[2];
+  const float oxygen = piston.gas.getOx() + target.values[3] - values[3];
+  piston.omega += target.values[0] - values[0];
+  piston.gas = Gas(nR * temperature / volume, volume, temperature,
+                   std::clamp(oxygen, 0.f, 1.f));
+}
+
+float CycleState::distance(const CycleState &a, const CycleState &b) {
+  float worst = 0.f;
+  for (int i = 0; i < SIZE; ++i) {
+    worst = std::max(worst, std::fabs(b.values[i] - a.values[i]) /
+                                scale(i, b.values[i]));
+  }
+  return worst;
+}
+
+SteadyStateTracker::SteadyStateTracker(const SteadyStateSettings &settings)
+    : settings{settings} {}
+
+SteadyStatus SteadyStateTracker::update(Piston &piston) {
+  const CycleState current = CycleState::of(piston);
+  if (primed && result.status == SteadyStatus::Running &&
+      previousHead < SECTION_ANGLE && piston.headAngle >= SECTION_ANGLE) {
+    /* Linear between the steps around the section */
+    const float fraction = (SECTION_ANGLE - previousHead) /
+                           (piston.headAngle - previousHead);
+    CycleState state;
+    for (int i = 0; i < CycleState::SIZE; ++i) {
+      state.values[i] = previous.values[i] +
+                        fraction * (current.values[i] - previous.values[i]);
+    }
+    endCycle(state, piston);
+  }
+
+  primed = true;
+  freeSpeed = piston.dynamicsIsActive;
+  previous = CycleState::of(piston);
+  previousHead = piston.headAngle;
+  return result.status;
+}
+
+void SteadyStateTracker::endCycle(const CycleState &state, Piston &piston) {
+  result.state = state;
+  if (historySize > 0) {
+    ++result.cycles;
+    result.residual = CycleState::distance(history[historySize - 1], state);
+    result.residuals.push_back(result.residual);
+    ++sinceExtrapolation;
+    /* The contraction is estimated either way, for the report */
+    const float bound = errorBound();
+    result.errorBound = freeSpeed ? bound : result.residual;
+    result.errorBounds.push_back(result.errorBound);
+    settled = (result.errorBound < settings.tolerance) ? settled + 1 : 0;
+    if (settled == 2) {
+      result.status = SteadyStatus::Converged;
+      return;
+    }
+    if (result.cycles >= settings.maxCycles) {
+      result.status = SteadyStatus::Failed;
+      return;
+    }
+  }
+
+  if (historySize == 3) {
+    std::rotate(history, history + 1, history + 3);
+    historySize = 2;
+  }
+  history[historySize++] = state;
+
+  CycleState limit = state;
+  if (historySize == 3 && settled == 0 &&
+      settings.acceleration == Acceleration::Aitken &&
+      result.contraction < settings.maxContraction && extrapolate(limit)) {
+    state.moveTo(limit, piston);
+    ++result.extrapolations;
+    history[0] = limit;
+    historySize = 1;
+    sinceExtrapolation = 0;
+  }
+}
+
+float SteadyStateTracker::errorBound() {
+  result.contraction = INFINITY;
+  if (sinceExtrapolation < 2 * SPAN) {
+    return INFINITY;
+  }
+  const float *last = result.residuals.data() + result.residuals.size();
+  double recent = 0.0, before = 0.0;
+  for (int i = 1; i <= SPAN; ++i) {
+    recent += static_cast<double>(last[-i]) * last[-i];
+    before += static_cast<double>(last[-SPAN - i]) * last[-SPAN - i];
+  }
+  if (before == 0.0) {
+    result.contraction = 0.f;
+    return 0.f; /* Settled exactly */
+  }
+  const float residual = std::sqrt(recent / SPAN);
+  result.contraction = std::pow(recent / before, 0.5 / SPAN);
+  const float r = result.contraction;
+  if (r > 1 + STATIONARY) {
+    return INFINITY;
+  }
+  return (r >= 1 - STATIONARY) ? residual : residual * r / (1 - r);
+}
+
+bool SteadyStateTracker::extrapolate(CycleState &state) const {
+  bool moved = false;
+  for (int i = 0; i < CycleState::SIZE; ++i) {
+    const float d1 = history[1].values[i] - history[0].values[i];
+    const float d2 = history[2].values[i] - history[1].values[i];
+    if (d1 == 0.f) {
+      continue;
+    }
+    /* Geometric convergence x_n = x* + c r^n, oscillating or not */
+    const float ratio = d2 / d1;
+    if (std::fabs(ratio) >= settings.maxRatio) {
+      continue;
+    }
+    const float limit = history[2].values[i] + d2 * ratio / (1 - ratio);
+    /* Never through zero, a stalled or empty cylinder would not recover */
+    if (limit * history[2].values[i] <= 0.f) {
+      continue;
+    }
+    state.values[i] = limit;
+    moved = true;
+  }
+  return moved;
+}
@@ -0,0 +1,126 @@
+#ifndef STEADYSTATE_HPP
+#define STEADYSTATE_HPP
+#include "Piston.hpp"
+#include <cmath>
+#include <vector>
+
+/* What one cycle hands over to the next, at the section angle. The rest of
+ * the piston state is set by the crank angle. */
+struct CycleState {
+  static constexpr int SIZE = 4;
+  float values[SIZE]; /* omega [rad/s], nR [J/K], temperature [K], oxygen */
+
+  static CycleState of(const Piston &piston);
+  /* Largest difference of a component, relative but absolute on oxygen */
+  static float distance(const CycleState &a, const CycleState &b);
+  /* Shifts the gas at the current volume, and omega, by target - *this */
+  void moveTo(const CycleState &target, Piston &piston) const;
+};
+
+enum class Acceleration {
+  None,  /* Plain cycle iteration */
+  Aitken /* Δ² extrapolation from three cycles of geometric convergence */
+};
+
+struct SteadyStateSettings {
+  /* Largest relative distance to the periodic state, as bounded from the
+   * residuals, see SteadyStateTracker. Where the steps fall in a cycle moves
+   * the spark and valve events a little, which leaves a cycle to cycle
+   * change of about 1e-3 at 10 kHz, proportional to the step. */
+  float tolerance = 2e-3f;
+  int maxCycles = 100;
+  Acceleration acceleration = Acceleration::None;
+  /* Aitken: below this ratio of successive changes a component is extrapolated,
+   * which bounds the jump to ratio / (1 - ratio) times the last change */
+  float maxRatio = 0.95f;
+  /* Aitken: only once the residuals contract by at most this per cycle. Δ²
+   * of the step jitter, or of a mode that barely contracts, jumps anywhere. */
+  float maxContraction = 0.9f;
+};
+
+enum class SteadyStatus { Running, Converged, Failed };
+
+struct SteadyStateReport {
+  SteadyStatus status = SteadyStatus::Running;
+  int cycles = 0;         /* Complete cycles observed */
+  int extrapolations = 0; /* Cycles started from an extrapolated state */
+  float residual = 0.f;   /* Of the last cycle */
+  /* Estimated, per cycle, and the distance to the periodic state bounded
+   * from it. Infinite until there are cycles enough to estimate. */
+  float contraction = INFINITY;
+  float errorBound = INFINITY;
+  CycleState state{};     /* At the last section */
+  std::vector<float> residuals;   /* One per cycle, the first one excluded */
+  std::vector<float> errorBounds; /* Likewise */
+};
+
+/* Finds the periodic steady state of the cycle map x -> F(x), where F runs
+ * one cycle from the state at a fixed head angle. update() follows every
+ * step, like CycleStats.
+ *
+ * The state is sampled mid-compression rather than at cycleTrigger: the
+ * valves are shut and nothing burns there, so the state interpolated
+ * between two steps does not depend on where the steps fall, while at the
+ * wrap of the head angle it jumps by a percent.
+ *
+ * With the speed imposed only the gas modes remain. They contract by about
+ * the residual gas fraction, well below a half, so the distance to the
+ * periodic state is below the residual and the residual is the bound: the
+ * gas settles in three to six cycles.
+ *
+ * A free running crankshaft adds a slow mode, which Aitken's Δ² process
+ * may shortcut: when three cycles in a row converge geometrically, every
+ * such component jumps to its limit and the piston continues from there.
+ * The step jitter blurs the ratios though, and it takes between 0.9x and
+ * 2x fewer cycles than plain iteration.
+ *
+ * With the speed free a small residual alone proves little: the slow mode
+ * contracts by about 0.96 per cycle, turning by a third of a turn every
+ * cycle, and the state is still 24 residuals away from its limit. The
+ * contraction r is estimated from the RMS residual of the last SPAN cycles
+ * against that of the SPAN before, which holds for turning modes too, and
+ * bounds the distance to the limit by residual r / (1 - r). Residuals that
+ * neither shrink nor grow, within STATIONARY, are the step jitter around a
+ * settled state: the bound is the residual then. Only cycles since the last
+ * extrapolation count, a jump is not a cycle of the map, and the next
+ * extrapolation waits for their estimate. Convergence takes the bound below
+ * the tolerance for two cycles in a row, one may be luck.
+ *
+ * The first section only sets the reference. */
+class SteadyStateTracker {
+public:
+  static constexpr float SECTION_ANGLE = 135.f; /* Head angle [deg] */
+  static constexpr int SPAN = 3;                 /* Cycles */
+  static constexpr float STATIONARY = 0.01f;
+
+  explicit SteadyStateTracker(const SteadyStateSettings &settings = {});
+
+  /* After every step, may shift the piston state at the section, see
+   * CycleState::moveTo() */
+  SteadyStatus update(Piston &piston);
+
+  const SteadyStateReport &report() const { return result; }
+
+private:
+  void endCycle(const CycleState &state, Piston &piston);
+  bool extrapolate(CycleState &state) const;
+  /* Of the residuals since the last extrapolation, sets the contraction */
+  float errorBound();
+
+  SteadyStateSettings settings;
+  SteadyStateReport result;
+
+  /* Previous step */
+  bool primed = false;
+  bool freeSpeed = true; /* Otherwise the residual bounds, see above */
+  CycleState previous{};
+  float previousHead = 0.f;
+
+  /* Cycle states since the last extrapolation, newest last */
+  CycleState history[3];
+  int historySize = 0;
+  int settled = 0; /* Cycles in a row bounded within the tolerance */
+  int sinceExtrapolation = 0; /* Residuals */
+};
+
+#endif
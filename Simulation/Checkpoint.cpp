@@ -0,0 +1,140 @@
+#include "Checkpoint.hpp"
+#include <algorithm>
+#include <cstdio>
+
+/* Members of version 1. Later versions append theirs at the end, read only
+ * when the checkpoint version has them. */
+template <typename Archive>
+static void fields(Archive &archive, SimState &s, uint32_t version) {
+  Piston &p = s.piston;
+  CylinderGeometry geometry = p.getGeometry();
+  CamProfile cam = p.getCam();
+  archive(geometry.bore, geometry.rod, geometry.stroke, geometry.addStroke,
+          geometry.momentOfInertia);
+  archive(cam.intakeCenter, cam.intakeWidth, cam.exhaustCenter,
+          cam.exhaustWidth);
+  /* The setters rebuild the crank tables */
+  if constexpr (std::is_same_v<Archive, CheckpointReader>) {
+    p.setGeometry(geometry);
+    p.setCam(cam);
+  }
+  archive(p.throttle, p.minThrottle, p.ignitionOn, p.omega, p.headAngle,
+          p.currentAngle, p.externalTorque, p.combustionAdvance, p.V_prime);
+  p.gas.serialize(archive);
+  archive(p.combustionInProgress, p.heatRelease, p.kexpl, p.intakeValve,
+          p.exhaustValve, p.intakeFlow, p.exhaustFlow, p.intakeCoef,
+          p.exhaustCoef, p.thermalK, p.dynamicsIsActive, p.cycleTrigger);
+
+  archive(s.engineSpeed, s.externalTorque, s.adaptive, s.substeps);
+  archive(s.stepper.tolerance.relative, s.stepper.tolerance.oxygen,
+          s.stepper.tolerance.minStep, s.stepper.tolerance.maxStep,
+          s.stepper.nextStep, s.stepper.accepted, s.stepper.rejected);
+  archive(s.sample.position, s.sample.pressure, s.sample.intake,
+          s.sample.exhaust, s.sample.torque, s.sample.temperature,
+          s.sample.oxygen);
+  s.stats.serialize(archive);
+  archive(s.simTime, s.stepCount, s.cycleCount, s.tickCount);
+
+  if (version >= 2) {
+    archive(s.meanValue);
+  } else {
+    s.meanValue = false; /* Only the detailed model then */
+  }
+  if (version >= 3) {
+    archive(s.meanValueMap);
+  } else {
+    s.meanValueMap = s.meanValue; /* Built on the first tick then */
+  }
+}
+
+static uint64_t fnv1a(std::span<const uint8_t> data) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (uint8_t byte : data) {
+    h = (h ^ byte) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+void saveCheckpoint(const SimState &state, std::vector<uint8_t> &out) {
+  CheckpointWriter writer(out);
+  uint32_t magic = CHECKPOINT_MAGIC, version = CHECKPOINT_VERSION, size = 0;
+  writer(magic, version, size);
+
+  /* serialize() takes its members by reference */
+  const size_t start = out.size();
+  SimState copy = state;
+  fields(writer, copy, version);
+
+  size = out.size() - start;
+  for (size_t i = 0; i < sizeof(size); ++i) {
+    out[start - sizeof(size) + i] = static_cast<uint8_t>(size >> (8 * i));
+  }
+  uint64_t checksum = fnv1a(std::span(out).subspan(start));
+  writer(checksum);
+}
+
+bool loadCheckpoint(std::span<const uint8_t> data, SimState &state) {
+  constexpr size_t HEADER = 3 * sizeof(uint32_t);
+  uint32_t magic = 0, version = 0, size = 0;
+  CheckpointReader header(data.first(std::min(data.size(), HEADER)));
+  header(magic, version, size);
+  if (!header.isComplete() || magic != CHECKPOINT_MAGIC || version == 0 ||
+      version > CHECKPOINT_VERSION ||
+      data.size() != HEADER + size + sizeof(uint64_t)) {
+    return false;
+  }
+
+  const std::span<const uint8_t> payload = data.subspan(HEADER, size);
+  uint64_t checksum = 0;
+  CheckpointReader trailer(data.subspan(HEADER + size));
+  trailer(checksum);
+  if (checksum != fnv1a(payload)) {
+    return false;
+  }
+
+  SimState loaded = state;
+  CheckpointReader reader(payload);
+  fields(reader, loaded, version);
+  if (!reader.isComplete()) {
+    return false;
+  }
+
+  state = loaded;
+  return true;
+}
+
+bool writeCheckpoint(const char *path, const SimState &state) {
+  std::vector<uint8_t> data;
+  saveCheckpoint(state, data);
+  return writeFile(path, data);
+}
+
+bool readCheckpoint(const char *path, SimState &state) {
+  std::vector<uint8_t> data;
+  return readFile(path, data) && loadCheckpoint(data, state);
+}
+
+bool writeFile(const char *path, std::span<const uint8_t> data) {
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const size_t written = fwrite(data.data(), 1, data.size(), file);
+  return (fclose(file) == 0) && written == data.size();
+}
+
+bool readFile(const char *path, std::vector<uint8_t> &data) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  data.clear();
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.insert(data.end(), chunk, chunk + n);
+  }
+  const bool ok = ferror(file) == 0;
+  fclose(file);
+  return ok;
+}
@@ -0,0 +1,114 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+#include "Simulation.hpp"
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/* Checkpoint layout, all values little endian:
+ *
+ *   "ESCK", u32 version, u32 payload size, payload, u64 FNV-1a of payload
+ *
+ * The payload lists the SimState members one after the other: f32, f64,
+ * integers at their own width, bools as one byte. Nothing derived is stored,
+ * the crank tables are rebuilt from the geometry on load. A new version only
+ * appends members, so a reader can load every version up to its own. */
+
+template <size_t N>
+using ArchiveBits = std::conditional_t<
+    N == 8, uint64_t,
+    std::conditional_t<N == 4, uint32_t,
+                       std::conditional_t<N == 2, uint16_t, uint8_t>>>;
+
+/* Archives for the serialize() members, little endian whatever the host.
+ * Sessions write their own fields through them too. */
+class CheckpointWriter {
+public:
+  explicit CheckpointWriter(std::vector<uint8_t> &out) : out{out} {}
+
+  template <typename... Ts> void operator()(Ts &...values) {
+    (put(values), ...);
+  }
+
+  /* Raw, e.g. a nested checkpoint */
+  void bytes(std::span<const uint8_t> data) {
+    out.insert(out.end(), data.begin(), data.end());
+  }
+
+private:
+  template <typename T> void put(T value) {
+    static_assert(std::is_arithmetic_v<T>);
+    const auto bits = std::bit_cast<ArchiveBits<sizeof(T)>>(value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+  }
+
+  std::vector<uint8_t> &out;
+};
+
+class CheckpointReader {
+public:
+  explicit CheckpointReader(std::span<const uint8_t> data) : data{data} {}
+
+  template <typename... Ts> void operator()(Ts &...values) {
+    (get(values), ...);
+  }
+
+  /* The next n bytes, empty if fewer are left */
+  std::span<const uint8_t> bytes(size_t n) {
+    if (data.size() - pos < n) {
+      valid = false;
+      return {};
+    }
+    pos += n;
+    return data.subspan(pos - n, n);
+  }
+
+  /* Every read so far was in range */
+  bool isValid() const { return valid; }
+  /* And the whole payload was consumed */
+  bool isComplete() const { return valid && pos == data.size(); }
+
+private:
+  template <typename T> void get(T &value) {
+    static_assert(std::is_arithmetic_v<T>);
+    if (data.size() - pos < sizeof(T)) {
+      valid = false;
+      return;
+    }
+    ArchiveBits<sizeof(T)> bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bits |= static_cast<ArchiveBits<sizeof(T)>>(data[pos++]) << (8 * i);
+    }
+    if constexpr (std::is_same_v<T, bool>) {
+      value = bits != 0;
+    } else {
+      value = std::bit_cast<T>(bits);
+    }
+  }
+
+  std::span<const uint8_t> data;
+  size_t pos = 0;
+  bool valid = true;
+};
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x4b435345; /* "ESCK" */
+/* 2: mean-value mode, 3: its map installed */
+constexpr uint32_t CHECKPOINT_VERSION = 3;
+
+void saveCheckpoint(const SimState &state, std::vector<uint8_t> &out);
+
+/* state is left untouched unless the whole checkpoint is valid */
+bool loadCheckpoint(std::span<const uint8_t> data, SimState &state);
+
+bool writeCheckpoint(const char *path, const SimState &state);
+bool readCheckpoint(const char *path, SimState &state);
+
+/* Whole files */
+bool writeFile(const char *path, std::span<const uint8_t> data);
+bool readFile(const char *path, std::vector<uint8_t> &data);
+
+#endif
@@ -0,0 +1,31 @@
+#include "FramePacer.hpp"
+#include <algorithm>
+#include <thread>
+
+using namespace std::chrono;
+
+constexpr FramePacer::Clock::duration MIN_MARGIN = microseconds(50);
+constexpr FramePacer::Clock::duration MAX_MARGIN = milliseconds(4);
+
+FramePacer::Clock::time_point
+FramePacer::waitUntil(Clock::time_point deadline) {
+  const Clock::time_point sleepEnd = deadline - margin;
+  if (Clock::now() < sleepEnd) {
+    std::this_thread::sleep_until(sleepEnd);
+    const Clock::duration late = Clock::now() - sleepEnd;
+    /* Towards twice the lateness, an eighth of the way up, a hundredth of
+     * the way down: an occasional preemption does not make it spin for
+     * milliseconds */
+    const Clock::duration target = 2 * late;
+    margin += (target - margin) / (target > margin ? 8 : 100);
+    margin = std::clamp(margin, MIN_MARGIN, MAX_MARGIN);
+  }
+
+  Clock::time_point now = Clock::now();
+  while (now < deadline) {
+    std::this_thread::yield();
+    now = Clock::now();
+  }
+  lateness = duration<float>(now - deadline).count();
+  return now;
+}
@@ -0,0 +1,29 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+#include <chrono>
+
+/* Waits for deadlines on the steady clock more precisely than the sleep of
+ * the OS, which wakes up late by up to a millisecond or more: it sleeps
+ * until a margin before the deadline, then spins the rest, yielding. The
+ * margin follows the lateness of the sleeps, faster up than down, so a
+ * quiet machine spins for a few tens of microseconds only. */
+class FramePacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /* Returns the wake-up time */
+  Clock::time_point waitUntil(Clock::time_point deadline);
+
+  /* Spun before a deadline [s] */
+  float getMargin() const {
+    return std::chrono::duration<float>(margin).count();
+  }
+  /* Lateness of the last wake-up [s] */
+  float getLateness() const { return lateness; }
+
+private:
+  Clock::duration margin = std::chrono::microseconds(500);
+  float lateness = 0.f;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "Session.hpp"
+#include "Checkpoint.hpp"
+
+/* Session file layout, all values little endian as in checkpoints:
+ *
+ *   header    "ESSN", u32 version, f32 period, u64 snapshot interval,
+ *             u64 end tick, u64 digest
+ *   events    u64 count, then per event: u64 tick, u32 type, f32 value
+ *   snapshots u64 count, then per snapshot: u32 size, checkpoint bytes
+ *
+ * Snapshots are checkpoints, see Checkpoint.hpp. */
+
+constexpr uint32_t SESSION_MAGIC = 0x4e535345; /* "ESSN" */
+constexpr uint32_t SESSION_VERSION = 2;
+
+SessionRecorder::SessionRecorder(const Simulation &sim, float period,
+                                 uint64_t snapshotInterval) {
+  session.period = period;
+  session.snapshotInterval = (snapshotInterval > 0) ? snapshotInterval : 1;
+  session.snapshots.push_back(sim.save());
+}
+
+void SessionRecorder::command(const Simulation &sim,
+                              const SimCommand &command) {
+  session.events.push_back({sim.tickCount, command});
+}
+
+void SessionRecorder::tick(const Simulation &sim) {
+  if ((sim.tickCount - session.startTick()) % session.snapshotInterval == 0) {
+    session.snapshots.push_back(sim.save());
+  }
+}
+
+const Session &SessionRecorder::finish(const Simulation &sim) {
+  session.endTick = sim.tickCount;
+  session.digest = stateDigest(sim.save());
+  return session;
+}
+
+SessionPlayer::SessionPlayer(const Session &session, Simulation &sim)
+    : session{session}, sim{sim}, nextEvent{0} {
+  seek(session.startTick());
+}
+
+void SessionPlayer::seek(uint64_t tick) {
+  /* Snapshots are in tick order */
+  const SimState *from = &session.snapshots.front();
+  for (const SimState &snapshot : session.snapshots) {
+    if (snapshot.tickCount > tick) {
+      break;
+    }
+    from = &snapshot;
+  }
+  sim.restore(*from);
+
+  nextEvent = 0;
+  while (nextEvent < session.events.size() &&
+         session.events[nextEvent].tick < sim.tickCount) {
+    ++nextEvent;
+  }
+  while (sim.tickCount < tick && step()) {
+  }
+}
+
+bool SessionPlayer::step() {
+  if (atEnd()) {
+    return false;
+  }
+  while (nextEvent < session.events.size() &&
+         session.events[nextEvent].tick == sim.tickCount) {
+    sim.apply(session.events[nextEvent++].command);
+  }
+  sim.tick(session.period);
+  return true;
+}
+
+/* FNV-1a */
+static void hash(uint64_t &h, const void *data, size_t size) {
+  const auto *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    h = (h ^ bytes[i]) * 0x100000001b3ull;
+  }
+}
+
+template <typename T> static void hash(uint64_t &h, const T &value) {
+  hash(h, &value, sizeof(value));
+}
+
+uint64_t stateDigest(const SimState &state) {
+  const Piston &p = state.piston;
+  const CycleSummary &last = state.stats.report().last;
+  uint64_t h = 0xcbf29ce484222325ull;
+
+  /* Field by field, the padding bytes are indeterminate */
+  for (float x : {p.omega, p.headAngle, p.currentAngle, p.V_prime,
+                  p.gas.getP(), p.gas.getV(), p.gas.getnR(), p.gas.getT(),
+                  p.gas.getOx(), p.heatRelease, p.intakeFlow, p.exhaustFlow,
+                  state.stepper.nextStep, last.torque, last.imep,
+                  last.peakPressure}) {
+    hash(h, x);
+  }
+  hash(h, p.combustionInProgress);
+  hash(h, state.simTime);
+  hash(h, state.stepCount);
+  hash(h, state.cycleCount);
+  hash(h, state.tickCount);
+  return h;
+}
+
+bool Session::save(const char *path) const {
+  std::vector<uint8_t> data;
+  CheckpointWriter writer(data);
+  uint32_t magic = SESSION_MAGIC, version = SESSION_VERSION;
+  float period = this->period;
+  uint64_t snapshotInterval = this->snapshotInterval,
+           endTick = this->endTick, digest = this->digest;
+  writer(magic, version, period, snapshotInterval, endTick, digest);
+
+  uint64_t eventCount = events.size();
+  writer(eventCount);
+  for (SessionEvent event : events) {
+    uint32_t type = event.command.type;
+    writer(event.tick, type, event.command.value);
+  }
+
+  uint64_t snapshotCount = snapshots.size();
+  writer(snapshotCount);
+  std::vector<uint8_t> checkpoint;
+  for (const SimState &snapshot : snapshots) {
+    checkpoint.clear();
+    saveCheckpoint(snapshot, checkpoint);
+    uint32_t size = checkpoint.size();
+    writer(size);
+    writer.bytes(checkpoint);
+  }
+
+  return writeFile(path, data);
+}
+
+bool Session::load(const char *path) {
+  std::vector<uint8_t> data;
+  if (!readFile(path, data)) {
+    return false;
+  }
+  CheckpointReader reader(data);
+
+  uint32_t magic = 0, version = 0;
+  uint64_t eventCount = 0;
+  reader(magic, version, period, snapshotInterval, endTick, digest,
+         eventCount);
+  bool ok = reader.isValid() && magic == SESSION_MAGIC &&
+            version == SESSION_VERSION;
+
+  events.clear();
+  for (uint64_t i = 0; ok && i < eventCount; ++i) {
+    SessionEvent event;
+    uint32_t type = 0;
+    reader(event.tick, type, event.command.value);
+    ok = reader.isValid() && type <= SimCommand::MeanValueMap;
+    event.command.type = static_cast<SimCommand::Type>(type);
+    events.push_back(event);
+  }
+
+  uint64_t snapshotCount = 0;
+  if (ok) {
+    reader(snapshotCount);
+    ok = reader.isValid() && snapshotCount > 0;
+  }
+
+  snapshots.clear();
+  for (uint64_t i = 0; ok && i < snapshotCount; ++i) {
+    uint32_t size = 0;
+    reader(size);
+    const std::span<const uint8_t> checkpoint = reader.bytes(size);
+    SimState state{.piston = Piston(CylinderGeometry())};
+    ok = reader.isValid() && loadCheckpoint(checkpoint, state);
+    if (ok) {
+      snapshots.push_back(state);
+    }
+  }
+  return ok && reader.isComplete();
+}
@@ -0,0 +1,69 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+#include "Simulation.hpp"
+#include <cstdint>
+#include <vector>
+
+/* Operator input, applied before the tick of the same number */
+struct SessionEvent {
+  uint64_t tick;
+  SimCommand command;
+};
+
+/* Recording of a run: the state it started from, every input after that and
+ * full states along the way to seek from. Replaying it steps the same ticks
+ * with the same inputs, so with the same build it is bit exact. */
+struct Session {
+  float period;              /* Simulated time per tick [s] */
+  uint64_t snapshotInterval; /* Ticks between two snapshots */
+  uint64_t endTick;
+  uint64_t digest; /* Of the final state */
+  std::vector<SessionEvent> events;
+  std::vector<SimState> snapshots; /* The first one is the start */
+
+  uint64_t startTick() const { return snapshots.front().tickCount; }
+
+  bool save(const char *path) const;
+  bool load(const char *path);
+};
+
+/* Hash of the simulated state, equal digests mean the runs did not diverge */
+uint64_t stateDigest(const SimState &state);
+
+/* Records a Simulation driven tick by tick, e.g. by SimThread */
+class SessionRecorder {
+public:
+  SessionRecorder(const Simulation &sim, float period,
+                  uint64_t snapshotInterval);
+
+  /* Before sim.apply(command) */
+  void command(const Simulation &sim, const SimCommand &command);
+  /* After sim.tick() */
+  void tick(const Simulation &sim);
+
+  const Session &finish(const Simulation &sim);
+
+private:
+  Session session;
+};
+
+/* Plays a Session back into a Simulation */
+class SessionPlayer {
+public:
+  SessionPlayer(const Session &session, Simulation &sim);
+
+  /* Restores the last snapshot at or before tick, then plays forward */
+  void seek(uint64_t tick);
+  /* Plays one tick, false at the end of the session */
+  bool step();
+
+  uint64_t position() const { return sim.tickCount; }
+  bool atEnd() const { return sim.tickCount >= session.endTick; }
+
+private:
+  const Session &session;
+  Simulation &sim;
+  size_t nextEvent;
+};
+
+#endif
@@ -0,0 +1,289 @@
+#include "SimThread.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+
+using namespace std::chrono;
+
+static SimSnapshot takeSnapshot(const Simulation &sim) {
+  return SimSnapshot{.piston = sim.piston,
+                     .engineSpeed = sim.engineSpeed,
+                     .externalTorque = sim.externalTorque,
+                     .cycle = {},
+                     .stats = sim.stats.report(),
+                     .cycleCount = sim.cycleCount,
+                     .simTime = sim.simTime,
+                     .stepCount = sim.stepCount,
+                     .substepRate = 0.f,
+                     .load = 0.f,
+                     .governed = false,
+                     .atFloor = false,
+                     .logOverflow = false,
+                     .meanValue = sim.meanValue,
+                     .meanValueMap = sim.meanValueMap,
+                     .meanValuePoint = sim.meanValuePoint,
+                     .published = steady_clock::now(),
+                     .inputLatency = 0.f,
+                     .maxInputLatency = 0.f};
+}
+
+static void copyCycle(std::vector<float> &dst, const CycleLogger &src) {
+  const std::span<const float> cycle = src.getV();
+  dst.assign(cycle.begin(), cycle.end());
+}
+
+SimThread::SimThread(Simulation &sim, float period, int substeps)
+    : sim{sim}, period{period}, running{false}, snapshots{takeSnapshot(sim)},
+      targetLoad{0.f}, recording{false} {
+  sim.substeps = substeps;
+
+  /* Publishing a longer cycle than any before must not allocate */
+  const size_t capacity = sim.pistonPosLog.getCapacity();
+  snapshots.forEach([capacity](SimSnapshot &snap) {
+    for (std::vector<float> *trace :
+         {&snap.cycle.position, &snap.cycle.pressure, &snap.cycle.intake,
+          &snap.cycle.exhaust, &snap.cycle.torque, &snap.cycle.temperature,
+          &snap.cycle.oxygen}) {
+      trace->reserve(capacity);
+    }
+  });
+}
+
+SimThread::~SimThread() { stop(); }
+
+void SimThread::start() {
+  if (running.exchange(true)) {
+    return;
+  }
+  thread = std::thread(&SimThread::loop, this);
+}
+
+void SimThread::stop() {
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool SimThread::send(SimCommand command, steady_clock::time_point origin) {
+  return commands.push({command, origin});
+}
+
+void SimThread::setSubsteps(int n) {
+  send({SimCommand::Substeps, static_cast<float>(n)});
+}
+
+void SimThread::startRecording(std::string path) {
+  std::lock_guard lock(recordMutex);
+  recordPath = std::move(path);
+  recording = true;
+}
+
+void SimThread::stopRecording() { recording = false; }
+
+const SimSnapshot &SimThread::snapshot() {
+  snapshots.update();
+  return snapshots.front();
+}
+
+void SimThread::loop() {
+  const auto period = duration_cast<steady_clock::duration>(
+      duration<float>(this->period));
+  auto next = steady_clock::now();
+  TRACE_THREAD("simulation");
+
+  while (running.load(std::memory_order_relaxed)) {
+    /* Accumulator: every period of wall time elapsed is owed one tick, a
+     * few at a time so that the thread catches up after a hiccup */
+    for (int ticks = 0;
+         ticks < MAX_CATCH_UP && steady_clock::now() >= next; ++ticks) {
+      tick();
+      next += period;
+    }
+
+    /* Still behind when overrunning: fall behind wall time rather than
+     * spiral into ever longer bursts */
+    if (next < steady_clock::now()) {
+      next = steady_clock::now();
+    }
+    pacer.waitUntil(next);
+  }
+
+  recording = false;
+  updateRecording();
+}
+
+void SimThread::tick() {
+  const auto start = steady_clock::now();
+  updateRecording();
+
+  /* Inputs are applied on tick boundaries only */
+  latencyWindow += period;
+  if (latencyWindow >= 1.f) {
+    maxInputLatency = inputLatency;
+    latencyWindow = 0.f;
+  }
+  QueuedCommand queued;
+  while (commands.pop(queued)) {
+    if (recorder) {
+      recorder->command(sim, queued.command);
+    }
+    sim.apply(queued.command);
+    inputLatency = duration<float>(start - queued.origin).count();
+    maxInputLatency = std::max(maxInputLatency, inputLatency);
+  }
+  governSubsteps();
+  updateMeanValueMap();
+
+  const uint64_t firstStep = sim.stepCount;
+  {
+    TRACE_SCOPE("substeps");
+    /* As Simulation::tick() picks them */
+    const bool fixedSteps =
+        !(sim.meanValue && sim.meanValueMap) && !sim.adaptive;
+    const auto stepStart = steady_clock::now();
+    sim.tick(period);
+    /* Adaptive and mean-value steps cost otherwise: the tick after them
+     * keeps the count, see SubstepGovernor::update() */
+    stepTime = fixedSteps
+                   ? duration<double>(steady_clock::now() - stepStart).count()
+                   : 0.0;
+  }
+  if (recorder) {
+    recorder->tick(sim);
+  }
+
+  const auto now = steady_clock::now();
+  publish(duration<float>(now - start).count() / period,
+          sim.stepCount - firstStep);
+}
+
+void SimThread::governSubsteps() {
+  const float target = targetLoad.load(std::memory_order_relaxed);
+  if (target <= 0.f || sim.adaptive || sim.meanValue) {
+    return;
+  }
+  governor.settings.targetLoad = target;
+  /* No more steps per cycle than the cycle logs hold at this speed, a
+   * cycle lasts 4 pi / omega */
+  const float logRate = sim.pressureLog.getCapacity() *
+                        std::fabs(sim.piston.omega) /
+                        (4 * std::numbers::pi_v<float>);
+  const int substeps =
+      governor.update(sim.substeps, stepTime, period, logRate);
+  if (substeps == sim.substeps) {
+    return;
+  }
+
+  /* Like any input, so that replays take the same steps */
+  const SimCommand command{SimCommand::Substeps,
+                           static_cast<float>(substeps)};
+  if (recorder) {
+    recorder->command(sim, command);
+  }
+  sim.apply(command);
+}
+
+void SimThread::updateMeanValueMap() {
+  const MeanValueSettings settings = sim.meanValueSettings(period);
+  if (mapBuild.valid() &&
+      mapBuild.wait_for(seconds(0)) == std::future_status::ready) {
+    TRACE_SCOPE("mean-value map ready");
+    auto table = std::make_shared<const MeanValueTable>(mapBuild.get());
+    /* Otherwise built for an older calibration, the next build follows */
+    if (!sim.meanValueMap && table->matches(sim.piston, settings)) {
+      installMeanValueMap(std::move(table));
+    }
+  }
+  if (!sim.meanValue || sim.meanValueMap) {
+    return;
+  }
+  if (sim.meanValueTable &&
+      sim.meanValueTable->matches(sim.piston, settings)) {
+    installMeanValueMap(sim.meanValueTable); /* Back to earlier settings */
+  } else if (!mapBuild.valid()) {
+    /* The simulation thread keeps its core */
+    const unsigned threads =
+        std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    mapBuild = std::async(std::launch::async,
+                          [calibration = sim.piston, settings, threads] {
+                            return MeanValueTable::build(calibration, settings,
+                                                         threads);
+                          });
+  }
+}
+
+void SimThread::installMeanValueMap(
+    std::shared_ptr<const MeanValueTable> table) {
+  sim.meanValueTable = std::move(table);
+  /* Like any input, so that replays switch on the same tick */
+  const SimCommand command{SimCommand::MeanValueMap, 1.f};
+  if (recorder) {
+    recorder->command(sim, command);
+  }
+  sim.apply(command);
+}
+
+void SimThread::updateRecording() {
+  const bool requested = recording.load(std::memory_order_relaxed);
+  if (requested == (recorder != nullptr)) {
+    return;
+  }
+
+  std::lock_guard lock(recordMutex);
+  if (requested) {
+    /* A snapshot every 5 s of simulated time */
+    const uint64_t interval = std::max(std::lround(5.f / period), 1l);
+    recorder = std::make_unique<SessionRecorder>(sim, period, interval);
+  } else {
+    TRACE_SCOPE("save session");
+    if (!recorder->finish(sim).save(recordPath.c_str())) {
+      fprintf(stderr, "Cannot write %s\n", recordPath.c_str());
+    }
+    recorder.reset();
+  }
+}
+
+void SimThread::publish(float load, uint64_t steps) {
+  TRACE_SCOPE("publish");
+  TRACE_COUNTER("sim load", load);
+  TRACE_COUNTER("steps per tick", static_cast<double>(steps));
+
+  SimSnapshot &snap = snapshots.back();
+  snap.piston = sim.piston;
+  snap.engineSpeed = sim.engineSpeed;
+  snap.externalTorque = sim.externalTorque;
+  snap.simTime = sim.simTime;
+  snap.stepCount = sim.stepCount;
+  snap.substepRate = steps / period;
+  snap.load = load;
+  snap.published = steady_clock::now();
+  snap.inputLatency = inputLatency;
+  snap.maxInputLatency = maxInputLatency;
+  snap.governed = targetLoad.load(std::memory_order_relaxed) > 0.f &&
+                  !sim.adaptive && !sim.meanValue;
+  snap.meanValue = sim.meanValue;
+  snap.meanValueMap = sim.meanValueMap;
+  snap.meanValuePoint = sim.meanValuePoint;
+  snap.atFloor = snap.governed && governor.atFloor();
+
+  /* Traces only change once per cycle */
+  if (snap.cycleCount != sim.cycleCount) {
+    TRACE_SCOPE("cycle logs");
+    copyCycle(snap.cycle.position, sim.pistonPosLog);
+    copyCycle(snap.cycle.pressure, sim.pressureLog);
+    copyCycle(snap.cycle.intake, sim.intakeLog);
+    copyCycle(snap.cycle.exhaust, sim.exhaustLog);
+    copyCycle(snap.cycle.torque, sim.torqueLog);
+    copyCycle(snap.cycle.temperature, sim.tempLog);
+    copyCycle(snap.cycle.oxygen, sim.oxyLog);
+    snap.stats = sim.stats.report();
+    snap.cycleCount = sim.cycleCount;
+    snap.logOverflow = sim.pressureLog.hasOverflowed();
+  }
+
+  snapshots.publish();
+}
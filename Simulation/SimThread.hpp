@@ -0,0 +1,135 @@
+#ifndef SIMTHREAD_HPP
+#define SIMTHREAD_HPP
+#include "FramePacer.hpp"
+#include "Session.hpp"
+#include "Simulation.hpp"
+#include "SpscQueue.hpp"
+#include "SubstepGovernor.hpp"
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Last complete cycle of every logged channel */
+struct CycleTraces {
+  std::vector<float> position;
+  std::vector<float> pressure;
+  std::vector<float> intake;
+  std::vector<float> exhaust;
+  std::vector<float> torque;
+  std::vector<float> temperature;
+  std::vector<float> oxygen;
+};
+
+/* State published by the simulation thread after every tick */
+struct SimSnapshot {
+  Piston piston;
+  float engineSpeed;
+  float externalTorque;
+
+  CycleTraces cycle;
+  CycleReport stats; /* Metrics of the same cycle as the traces */
+  uint64_t cycleCount;
+
+  double simTime;
+  uint64_t stepCount;
+  float substepRate; /* Steps per simulated second [Hz] */
+  float load;        /* Busy fraction of the tick period */
+  bool governed;     /* Substeps picked by the governor */
+  bool atFloor;      /* Governor held at its accuracy floor */
+  bool logOverflow;  /* The traced cycle outgrew the log capacity */
+  bool meanValue;    /* Mean-value model, see Simulation::advanceMeanValue */
+  bool meanValueMap; /* Its map is in place, detailed steps until then */
+  MeanValuePoint meanValuePoint;
+  /* When the tick ended, simTime then matched it on the wall clock */
+  std::chrono::steady_clock::time_point published;
+  /* From the input event to the tick that applied it, last command and
+   * worst over the last second [s] */
+  float inputLatency;
+  float maxInputLatency;
+};
+
+/* Runs a Simulation on its own thread, advancing a fixed amount of simulated
+ * time per tick in step with the wall clock: an accumulator owes one tick
+ * per period of wall time, and a FramePacer wakes the thread on time.
+ * Inputs come in through a command queue, state goes out through a triple
+ * buffer: the render loop never blocks on the physics and vice versa. */
+class SimThread {
+public:
+  SimThread(Simulation &sim, float period, int substeps);
+  ~SimThread();
+
+  void start();
+  void stop();
+
+  /* Render thread side. origin is when the input that caused the command
+   * happened, e.g. its event timestamp */
+  bool send(SimCommand command, std::chrono::steady_clock::time_point origin =
+                                    std::chrono::steady_clock::now());
+  void setSubsteps(int substeps);
+  /* Lets the substeps follow the machine, see SubstepGovernor, for fixed
+   * steps only. 0 hands them back to setSubsteps(). */
+  void setTargetLoad(float load) { targetLoad = load; }
+  float getTargetLoad() const { return targetLoad; }
+  const SimSnapshot &snapshot();
+
+  /* Records the inputs from the next tick on, the session is written to
+   * path by the simulation thread when recording stops */
+  void startRecording(std::string path);
+  void stopRecording();
+  bool isRecording() const { return recording; }
+
+private:
+  static constexpr int MAX_CATCH_UP = 5; /* Ticks per wake-up */
+
+  void loop();
+  void tick();
+  void publish(float load, uint64_t steps);
+  void updateRecording();
+  void governSubsteps();
+  void updateMeanValueMap();
+  void installMeanValueMap(std::shared_ptr<const MeanValueTable> table);
+
+  Simulation &sim;
+  const float period; /* Simulated (and wall) time per tick [s] */
+
+  std::thread thread;
+  FramePacer pacer;
+  std::atomic<bool> running;
+
+  struct QueuedCommand {
+    SimCommand command;
+    std::chrono::steady_clock::time_point origin;
+  };
+  SpscQueue<QueuedCommand, 256> commands;
+  TripleBuffer<SimSnapshot> snapshots;
+
+  std::atomic<float> targetLoad;
+  SubstepGovernor governor;
+  /* Wall time of the last tick's fixed substeps [s], 0 when it took
+   * adaptive or mean-value steps */
+  double stepTime = 0.0;
+
+  /* Engine map for the mean-value model, built off the simulation thread.
+   * One build at a time: edits made meanwhile are coalesced into the next
+   * one, for whatever the calibration is when it starts. Stopping waits for
+   * the build in progress. */
+  std::future<MeanValueTable> mapBuild;
+
+  float inputLatency = 0.f;
+  float maxInputLatency = 0.f;
+  float latencyWindow = 0.f; /* Time since the maximum was reset [s] */
+
+  /* Requested by the render thread, acted upon between two ticks */
+  std::atomic<bool> recording;
+  std::mutex recordMutex;
+  std::string recordPath;
+  std::unique_ptr<SessionRecorder> recorder;
+};
+
+#endif
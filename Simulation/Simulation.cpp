@@ -0,0 +1,227 @@
+#include "Simulation.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+
+Simulation::Simulation(CylinderGeometry geometry)
+    : piston{geometry}, engineSpeed{100.f}, externalTorque{}, adaptive{false},
+      substeps{200}, meanValue{false}, meanValueMap{false}, sample{},
+      simTime{}, stepCount{},
+      cycleCount{}, tickCount{} {}
+
+Simulation::Simulation(const SimState &state, int logCapacity)
+    : piston{state.piston}, pistonPosLog{logCapacity},
+      pressureLog{logCapacity}, intakeLog{logCapacity},
+      exhaustLog{logCapacity}, torqueLog{logCapacity}, tempLog{logCapacity},
+      oxyLog{logCapacity} {
+  restore(state);
+}
+
+void Simulation::apply(const SimCommand &command) {
+  /* The substep governor retunes the step every few ticks and the map
+   * arrives when built, the cycle metrics carry over */
+  if (command.type != SimCommand::Substeps &&
+      command.type != SimCommand::MeanValueMap) {
+    stats.restart();
+  }
+  const Piston before = piston;
+  const int beforeSubsteps = substeps;
+  const bool beforeAdaptive = adaptive;
+
+  switch (command.type) {
+  case SimCommand::Throttle:
+    piston.throttle = command.value;
+    break;
+  case SimCommand::ExternalTorque:
+    externalTorque = command.value;
+    break;
+  case SimCommand::EngineSpeed:
+    engineSpeed = command.value;
+    break;
+  case SimCommand::Ignition:
+    piston.ignitionOn = command.value != 0.f;
+    break;
+  case SimCommand::Dynamics:
+    piston.dynamicsIsActive = command.value != 0.f;
+    break;
+  case SimCommand::CombustionK:
+    piston.kexpl = command.value;
+    break;
+  case SimCommand::CombustionAdvance:
+    piston.combustionAdvance = command.value;
+    break;
+  case SimCommand::ThermalK:
+    piston.thermalK = command.value;
+    break;
+  case SimCommand::IntakeK:
+    piston.intakeCoef = command.value;
+    break;
+  case SimCommand::ExhaustK:
+    piston.exhaustCoef = command.value;
+    break;
+  case SimCommand::MinThrottle:
+    piston.minThrottle = command.value;
+    break;
+  case SimCommand::Adaptive:
+    adaptive = command.value != 0.f;
+    break;
+  case SimCommand::Substeps:
+    substeps = std::max(static_cast<int>(command.value), 1);
+    break;
+  case SimCommand::MeanValue:
+    meanValue = command.value != 0.f;
+    break;
+  case SimCommand::MeanValueMap:
+    meanValueMap = command.value != 0.f;
+    break;
+  }
+
+  if (!sameCalibration(piston, before) || substeps != beforeSubsteps ||
+      adaptive != beforeAdaptive) {
+    meanValueMap = false;
+  }
+}
+
+void Simulation::step(float deltaT) {
+  piston.updatePosition(deltaT, engineSpeed);
+  piston.applyExtTorque(externalTorque);
+  record(deltaT);
+}
+
+void Simulation::advance(double duration) {
+  piston.applyExtTorque(externalTorque);
+  stepper.advance(piston, duration, engineSpeed,
+                  [this](float deltaT) { record(deltaT); });
+}
+
+MeanValueSettings Simulation::meanValueSettings(float period) const {
+  MeanValueSettings settings;
+  settings.sweep.substepRate = substeps / period;
+  settings.sweep.adaptive = adaptive;
+  settings.sweep.stepTolerance = stepper.tolerance;
+  return settings;
+}
+
+void Simulation::advanceMeanValue(double duration) {
+  piston.applyExtTorque(externalTorque);
+  const MeanValueSettings settings = meanValueSettings(duration);
+  if (!meanValueTable || !meanValueTable->matches(piston, settings)) {
+    TRACE_SCOPE("mean-value table");
+    meanValueTable = std::make_shared<const MeanValueTable>(
+        MeanValueTable::build(piston, settings));
+  }
+
+  const int steps =
+      std::max(static_cast<int>(std::ceil(duration / MEAN_VALUE_STEP)), 1);
+  const float deltaT = duration / steps;
+  for (int i = 0; i < steps; ++i) {
+    cycleCount += meanValueStep(*meanValueTable, piston, deltaT, engineSpeed);
+    simTime += deltaT;
+  }
+  stepCount += steps;
+  meanValuePoint = meanValueTable->at(piston.omega, piston.throttle,
+                                      piston.combustionAdvance);
+}
+
+void Simulation::record(float deltaT) {
+  /* Log Data */
+  sample = {.position = piston.getPistonPosition(),
+            .pressure = PAToATM(piston.gas.getP()),
+            .intake = piston.intakeFlow,
+            .exhaust = piston.exhaustFlow,
+            .torque = piston.getTorque(),
+            .temperature = KELVToCELS(piston.gas.getT()),
+            .oxygen = piston.gas.getOx()};
+  pistonPosLog.addSample(sample.position);
+  pressureLog.addSample(sample.pressure);
+  intakeLog.addSample(sample.intake);
+  exhaustLog.addSample(sample.exhaust);
+  torqueLog.addSample(sample.torque);
+  tempLog.addSample(sample.temperature);
+  oxyLog.addSample(sample.oxygen);
+
+  /* Time weighted, as steps may differ in size */
+  stats.update(piston, sample.torque, deltaT);
+
+  if (piston.cycleTrigger) {
+    TRACE_SCOPE("cycle end");
+    stats.endCycle();
+    pistonPosLog.trig();
+    pressureLog.trig();
+    intakeLog.trig();
+    exhaustLog.trig();
+    torqueLog.trig();
+    tempLog.trig();
+    oxyLog.trig();
+    piston.cycleTrigger = false;
+    ++cycleCount;
+  }
+
+  simTime += deltaT;
+  ++stepCount;
+
+  if (onStep) {
+    onStep(deltaT);
+  }
+}
+
+void Simulation::run(double duration, float deltaT) {
+  const uint64_t steps = std::llround(duration / deltaT);
+  for (uint64_t i = 0; i < steps; ++i) {
+    step(deltaT);
+  }
+}
+
+void Simulation::tick(float period) {
+  if (meanValue && meanValueMap) {
+    advanceMeanValue(period);
+  } else if (adaptive) {
+    advance(period);
+  } else {
+    for (int i = 0; i < substeps; ++i) {
+      step(period / substeps);
+    }
+  }
+  ++tickCount;
+}
+
+SimState Simulation::save() const {
+  return SimState{.piston = piston,
+                  .engineSpeed = engineSpeed,
+                  .externalTorque = externalTorque,
+                  .adaptive = adaptive,
+                  .substeps = substeps,
+                  .meanValue = meanValue,
+                  .meanValueMap = meanValueMap,
+                  .stepper = stepper,
+                  .sample = sample,
+                  .stats = stats,
+                  .simTime = simTime,
+                  .stepCount = stepCount,
+                  .cycleCount = cycleCount,
+                  .tickCount = tickCount};
+}
+
+void Simulation::restore(const SimState &state) {
+  piston = state.piston;
+  engineSpeed = state.engineSpeed;
+  externalTorque = state.externalTorque;
+  adaptive = state.adaptive;
+  substeps = state.substeps;
+  meanValue = state.meanValue;
+  meanValueMap = state.meanValueMap;
+  stepper = state.stepper;
+  sample = state.sample;
+  stats = state.stats;
+  simTime = state.simTime;
+  stepCount = state.stepCount;
+  cycleCount = state.cycleCount;
+  tickCount = state.tickCount;
+}
+
+Simulation Simulation::fork(int logCapacity) const {
+  Simulation copy(save(), logCapacity);
+  copy.meanValueTable = meanValueTable;
+  copy.meanValuePoint = meanValuePoint;
+  return copy;
+}
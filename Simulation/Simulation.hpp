@@ -0,0 +1,157 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+#include "AdaptiveStepper.hpp"
+#include "CycleStats.hpp"
+#include "Logger.hpp"
+#include "MeanValueModel.hpp"
+#include "Piston.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+/* Operator input, applied between two substeps */
+struct SimCommand {
+  enum Type {
+    Throttle,
+    ExternalTorque,
+    EngineSpeed,
+    Ignition,
+    Dynamics,
+    CombustionK,
+    CombustionAdvance,
+    ThermalK,
+    IntakeK,
+    ExhaustK,
+    MinThrottle,
+    Adaptive,
+    Substeps,
+    MeanValue,
+    /* The engine map for the calibration and stepping of now is installed,
+     * see Simulation::meanValueMap */
+    MeanValueMap,
+  };
+
+  Type type;
+  float value;
+};
+
+/* Channels logged by one step, in display units */
+struct SimSample {
+  float position;    /* [m] */
+  float pressure;    /* [atm] */
+  float intake;      /* Intake flow */
+  float exhaust;     /* Exhaust flow */
+  float torque;      /* [Nm] */
+  float temperature; /* [°C] */
+  float oxygen;
+};
+
+/* Everything the future of a Simulation depends on, the logs excluded. Plain
+ * data, so saving and restoring it is a copy. */
+struct SimState {
+  Piston piston;
+  float engineSpeed = 0.f;
+  float externalTorque = 0.f;
+  bool adaptive = false;
+  int substeps = 1;
+  bool meanValue = false;
+  bool meanValueMap = false;
+  AdaptiveStepper stepper{};
+  SimSample sample{};
+  CycleStats stats{};
+  double simTime = 0.0;
+  uint64_t stepCount = 0;
+  uint64_t cycleCount = 0;
+  uint64_t tickCount = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<SimState>);
+
+/* Piston, operator inputs and cycle logs, stepped without any frontend */
+class Simulation {
+public:
+  Simulation(CylinderGeometry geometry);
+  /* Resumes a saved state, logging up to logCapacity samples per cycle */
+  explicit Simulation(const SimState &state,
+                      int logCapacity = DEFAULT_CYCLE_CAPACITY);
+
+  void apply(const SimCommand &command);
+  void step(float deltaT);
+  void run(double duration, float deltaT);
+
+  /* One SimThread tick: advanceMeanValue() in mean-value mode once the map
+   * is installed, advance() when adaptive, else substeps fixed steps */
+  void tick(float period);
+
+  /* Variable steps under error control, one log sample per step */
+  void advance(double duration);
+
+  /* Crankshaft speed only, under the cycle mean torque of the engine map,
+   * see meanValueStep(). Neither logs nor onStep follow it: the traces and
+   * cycle metrics hold the last detailed cycle. A missing or stale map is
+   * built first, on this thread. */
+  void advanceMeanValue(double duration);
+
+  /* Of the engine map standing in for the detailed model as it steps now:
+   * substeps per tick of period, or the adaptive tolerance */
+  MeanValueSettings meanValueSettings(float period) const;
+
+  Piston piston;
+
+  /* Inputs */
+  float engineSpeed;
+  float externalTorque;
+  bool adaptive; /* Integrator used by tick() */
+  int substeps;  /* Fixed steps per tick */
+  bool meanValue; /* Mean-value model used by tick() */
+  /* A map for the calibration and stepping of now was installed, by a
+   * MeanValueMap command, and none of them changed since. Until then
+   * tick() stays with the detailed model: SimThread builds the map off its
+   * thread, which takes seconds, and sends the command with the map in
+   * place. A replay or a restored state rebuilds the map where the command
+   * was, so it steps the same. */
+  bool meanValueMap;
+  AdaptiveStepper stepper;
+
+  /* Engine map of the mean-value model, built from the detailed model.
+   * Immutable, shared with forks. */
+  std::shared_ptr<const MeanValueTable> meanValueTable;
+  MeanValuePoint meanValuePoint{}; /* End of the last mean-value tick */
+
+  /* Last step */
+  SimSample sample;
+  /* Called after every step on the stepping thread, e.g. to feed audio */
+  std::function<void(float deltaT)> onStep;
+
+  /* Cycle logs */
+  CycleLogger pistonPosLog;
+  CycleLogger pressureLog;
+  CycleLogger intakeLog;
+  CycleLogger exhaustLog;
+  CycleLogger torqueLog;
+  CycleLogger tempLog;
+  CycleLogger oxyLog;
+
+  /* Statistics, the cycle metrics restart on every command but Substeps
+   * and MeanValueMap */
+  CycleStats stats;
+  double simTime;
+  uint64_t stepCount;
+  uint64_t cycleCount;
+  uint64_t tickCount;
+
+  /* The logs keep their samples across a restore */
+  SimState save() const;
+  void restore(const SimState &state);
+
+  /* Independent continuation of this run, sharing nothing with it. Without
+   * logs a fork is a copy of a few hundred bytes, cheap enough to branch a
+   * warmed up engine into many what-if runs. */
+  Simulation fork(int logCapacity = 0) const;
+
+private:
+  void record(float deltaT);
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "SubstepGovernor.hpp"
+#include <algorithm>
+#include <cmath>
+
+SubstepGovernor::SubstepGovernor(const GovernorSettings &settings)
+    : settings{settings} {}
+
+int SubstepGovernor::update(int substeps, double busy, float period,
+                            float rateLimit) {
+  if (substeps <= 0 || busy <= 0.0) {
+    return std::max(substeps, 1);
+  }
+
+  const double sample = busy / substeps;
+  cost = (cost == 0.0) ? sample : cost + settings.smoothing * (sample - cost);
+  affordableRate = static_cast<float>(settings.targetLoad / cost);
+
+  const float minSteps = std::max(settings.minRate * period, 1.f);
+  const float maxRate = std::min(settings.maxRate, rateLimit);
+  const float maxSteps = std::max(maxRate * period, minSteps);
+  floor = affordableRate * period < minSteps;
+  const float target =
+      std::clamp(affordableRate * period, minSteps, maxSteps);
+
+  const float ratio = target / substeps;
+  if (std::fabs(ratio - 1.f) < settings.deadBand) {
+    return static_cast<int>(
+        std::clamp(static_cast<float>(substeps), minSteps, maxSteps));
+  }
+  const float change =
+      std::clamp(ratio, 1.f / settings.maxChange, settings.maxChange);
+  return static_cast<int>(
+      std::clamp(std::round(substeps * change), minSteps, maxSteps));
+}
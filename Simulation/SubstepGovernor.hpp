@@ -0,0 +1,46 @@
+#ifndef SUBSTEPGOVERNOR_HPP
+#define SUBSTEPGOVERNOR_HPP
+#include <cmath>
+
+struct GovernorSettings {
+  float targetLoad = 0.5f; /* Busy fraction of the tick period */
+  float minRate = 5000.f;  /* Accuracy floor [Hz], held even when overrunning */
+  float maxRate = 2e5f;    /* [Hz] */
+  float smoothing = 0.1f;  /* Weight of the newest cost sample */
+  float deadBand = 0.1f;   /* Relative change not worth acting on */
+  float maxChange = 1.25f; /* Largest factor per tick */
+};
+
+/* Picks the fixed substep count of every SimThread tick from the measured
+ * cost of the previous batches, so that stepping takes targetLoad of the
+ * tick period: fidelity scales with the machine.
+ *
+ * The cost of one step barely depends on how many are taken, so the
+ * governor tracks that cost rather than the load itself and the loop has no
+ * gain to tune. The cost is smoothed, small corrections are ignored and
+ * large ones spread over several ticks, which keeps scheduling noise from
+ * making the count oscillate. */
+class SubstepGovernor {
+public:
+  explicit SubstepGovernor(const GovernorSettings &settings = {});
+
+  /* After a tick of period that took steps in busy seconds of wall time,
+   * returns the substeps of the next tick. rateLimit tightens maxRate for
+   * it, e.g. to what the cycle logs hold; the accuracy floor still wins. */
+  int update(int substeps, double busy, float period,
+             float rateLimit = INFINITY);
+
+  /* Step rate the machine would sustain at the target load [Hz] */
+  float getAffordableRate() const { return affordableRate; }
+  /* Whether the accuracy floor costs more than the target load */
+  bool atFloor() const { return floor; }
+
+  GovernorSettings settings;
+
+private:
+  double cost = 0.0; /* Smoothed wall time per step [s] */
+  float affordableRate = 0.f;
+  bool floor = false;
+};
+
+#endif
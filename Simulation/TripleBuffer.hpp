@@ -0,0 +1,47 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+#include <atomic>
+
+/* Lock-free single producer / single consumer triple buffer.
+ * The producer fills back() and publishes it; the consumer picks up the most
+ * recently published buffer with update() and reads it through front().
+ * Neither side ever waits for the other. */
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer(const T &initial) : buffers{initial, initial, initial} {}
+
+  /* Before either side runs, e.g. to reserve memory in every buffer */
+  template <typename F> void forEach(F &&f) {
+    for (T &buffer : buffers) {
+      f(buffer);
+    }
+  }
+
+  /* Producer side */
+  T &back() { return buffers[backIdx]; }
+  void publish() {
+    backIdx = middle.exchange(backIdx | DIRTY, std::memory_order_acq_rel) &
+              INDEX;
+  }
+
+  /* Consumer side */
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & DIRTY)) {
+      return false;
+    }
+    frontIdx = middle.exchange(frontIdx, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+  const T &front() const { return buffers[frontIdx]; }
+
+private:
+  static constexpr int INDEX = 3;
+  static constexpr int DIRTY = 4;
+
+  T buffers[3];
+  int backIdx = 0;
+  std::atomic<int> middle = 1;
+  int frontIdx = 2;
+};
+
+#endif
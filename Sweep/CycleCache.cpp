@@ -0,0 +1,226 @@
+#include "CycleCache.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+constexpr uint32_t STORE_MAGIC = 0x45434343; /* "CCCE" */
+/* Bump when the model changes: stored cycles are then recomputed */
+constexpr uint32_t STORE_VERSION = 4;
+constexpr uint32_t MAX_PROBES = 8;
+
+struct StoreHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slots;
+  uint32_t slotSize;
+};
+
+struct StoreSlot {
+  uint32_t used;
+  CycleKey key;
+  CycleEntry entry;
+};
+
+static_assert(std::is_trivially_copyable_v<StoreSlot>);
+static_assert(sizeof(StoreHeader) % alignof(StoreSlot) == 0);
+
+/* Rounded to 15 mantissa bits, carrying into the exponent */
+static uint32_t quantize(float x) {
+  if (x == 0.f) {
+    return 0; /* -0 too */
+  }
+  return (std::bit_cast<uint32_t>(x) + 0x80u) & 0xffffff00u;
+}
+
+CycleKey CycleKey::of(const Piston &piston, float speed,
+                      const SweepSettings &settings) {
+  const CylinderGeometry &g = piston.getGeometry();
+  const CamProfile &cam = piston.getCam();
+  const float floats[] = {
+      g.bore, g.rod, g.stroke, g.addStroke, g.momentOfInertia,
+      cam.intakeCenter, cam.intakeWidth, cam.exhaustCenter, cam.exhaustWidth,
+      piston.throttle, piston.minThrottle, piston.combustionAdvance,
+      piston.kexpl, piston.thermalK, piston.intakeCoef, piston.exhaustCoef,
+      speed, settings.adaptive ? 0.f : settings.substepRate,
+      settings.untilSteady ? settings.steadyTolerance : 0.f};
+  /* The step tolerance only matters to adaptive steps */
+  const StepTolerance &step = settings.stepTolerance;
+  const float tolerances[] = {step.relative, step.oxygen, step.minStep,
+                              step.maxStep};
+  constexpr int FLOATS = sizeof(floats) / sizeof(floats[0]);
+  constexpr int TOLERANCES = sizeof(tolerances) / sizeof(tolerances[0]);
+  static_assert(FLOATS + TOLERANCES + 4 == SIZE);
+
+  CycleKey key{};
+  for (int i = 0; i < FLOATS; ++i) {
+    key.values[i] = quantize(floats[i]);
+  }
+  for (int i = 0; i < TOLERANCES; ++i) {
+    key.values[FLOATS + i] =
+        settings.adaptive ? quantize(tolerances[i]) : 0u;
+  }
+  key.values[FLOATS + TOLERANCES] = piston.ignitionOn;
+  key.values[FLOATS + TOLERANCES + 1] = settings.warmupCycles;
+  key.values[FLOATS + TOLERANCES + 2] = settings.measuredCycles;
+  key.values[FLOATS + TOLERANCES + 3] = settings.adaptive;
+
+  /* FNV-1a, byte by byte: whole words would leave the low bits, which pick
+   * the store slot, to the low bytes alone */
+  key.hash = 0xcbf29ce484222325ull;
+  const auto *bytes = reinterpret_cast<const unsigned char *>(key.values);
+  for (size_t i = 0; i < sizeof(key.values); ++i) {
+    key.hash = (key.hash ^ bytes[i]) * 0x100000001b3ull;
+  }
+  return key;
+}
+
+bool CycleKey::operator==(const CycleKey &other) const {
+  return std::equal(values, values + SIZE, other.values);
+}
+
+CycleCache::CycleCache(size_t capacity)
+    : capacity{std::max<size_t>(capacity, 1)} {}
+
+CycleCache::~CycleCache() { closeStore(); }
+
+bool CycleCache::find(const CycleKey &key, CycleEntry &entry) {
+  std::lock_guard lock(mutex);
+  const auto found = index.find(key);
+  if (found != index.end()) {
+    entries.splice(entries.begin(), entries, found->second);
+    entry = found->second->second;
+    ++hits;
+    return true;
+  }
+  if (findStored(key, entry)) {
+    remember(key, entry);
+    ++hits;
+    ++storeHits;
+    return true;
+  }
+  ++misses;
+  return false;
+}
+
+void CycleCache::insert(const CycleKey &key, const CycleEntry &entry) {
+  std::lock_guard lock(mutex);
+  remember(key, entry);
+  store(key, entry);
+}
+
+void CycleCache::remember(const CycleKey &key, const CycleEntry &entry) {
+  const auto found = index.find(key);
+  if (found != index.end()) {
+    found->second->second = entry;
+    entries.splice(entries.begin(), entries, found->second);
+    return;
+  }
+  if (entries.size() >= capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  entries.emplace_front(key, entry);
+  index.emplace(key, entries.begin());
+}
+
+bool CycleCache::openStore(const char *path, uint32_t slots) {
+  std::lock_guard lock(mutex);
+  closeStore();
+  if (slots == 0) {
+    return false;
+  }
+
+  const int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  const StoreHeader expected = {STORE_MAGIC, STORE_VERSION, slots,
+                                sizeof(StoreSlot)};
+  const size_t size = sizeof(StoreHeader) + size_t{slots} * sizeof(StoreSlot);
+
+  /* Anything else than the expected header and size is started over */
+  StoreHeader header{};
+  struct stat st;
+  const bool valid =
+      fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == size &&
+      pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+      memcmp(&header, &expected, sizeof(header)) == 0;
+  if (!valid && (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0 ||
+                 pwrite(fd, &expected, sizeof(expected), 0) !=
+                     sizeof(expected))) {
+    ::close(fd);
+    return false;
+  }
+
+  void *mapped =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  map = static_cast<uint8_t *>(mapped);
+  mapSize = size;
+  this->slots = slots;
+  return true;
+}
+
+void CycleCache::closeStore() {
+  if (map != nullptr) {
+    munmap(map, mapSize);
+  }
+  map = nullptr;
+  mapSize = 0;
+  slots = 0;
+}
+
+/* Start of slot i, read and written with memcpy like any file data */
+static uint8_t *slotAt(uint8_t *map, uint32_t i) {
+  return map + sizeof(StoreHeader) + size_t{i} * sizeof(StoreSlot);
+}
+
+bool CycleCache::findStored(const CycleKey &key, CycleEntry &entry) const {
+  if (map == nullptr) {
+    return false;
+  }
+  StoreSlot slot;
+  for (uint32_t probe = 0; probe < std::min(MAX_PROBES, slots); ++probe) {
+    memcpy(&slot, slotAt(map, (key.hash + probe) % slots), sizeof(slot));
+    if (!slot.used) {
+      return false;
+    }
+    if (slot.key == key) {
+      entry = slot.entry;
+      return true;
+    }
+  }
+  return false;
+}
+
+void CycleCache::store(const CycleKey &key, const CycleEntry &entry) {
+  if (map == nullptr) {
+    return;
+  }
+
+  /* Linear probing, a full neighbourhood gives up its first slot */
+  uint32_t target = key.hash % slots;
+  for (uint32_t probe = 0; probe < std::min(MAX_PROBES, slots); ++probe) {
+    const uint32_t i = (key.hash + probe) % slots;
+    StoreSlot slot;
+    memcpy(&slot, slotAt(map, i), sizeof(slot));
+    if (!slot.used || slot.key == key) {
+      target = i;
+      break;
+    }
+  }
+
+  StoreSlot slot{};
+  slot.used = 1;
+  slot.key = key;
+  slot.entry = entry;
+  memcpy(slotAt(map, target), &slot, sizeof(slot));
+}
@@ -0,0 +1,75 @@
+#ifndef CYCLECACHE_HPP
+#define CYCLECACHE_HPP
+#include "Sweep.hpp"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/* Everything a cycle result depends on: the geometry and cam, the inputs
+ * and calibration of the piston, the speed and the sweep settings. Floats
+ * are rounded to 15 mantissa bits, 3e-5 relative, so that points equal up
+ * to the last bits share an entry. */
+struct CycleKey {
+  static constexpr int SIZE = 27;
+  uint32_t values[SIZE];
+  uint64_t hash;
+
+  static CycleKey of(const Piston &piston, float speed,
+                     const SweepSettings &settings);
+
+  bool operator==(const CycleKey &other) const;
+};
+
+struct CycleEntry {
+  CycleResult result;
+  CycleProfile profile; /* Last measured cycle */
+};
+
+/* Converged cycles by operating point, the least recently used dropped
+ * beyond capacity. An optional store keeps them across runs in a memory
+ * mapped file of fixed size slots, addressed by the key hash: a point missing
+ * in memory is looked up there, and every new one is written to both.
+ *
+ * Thread safe. The store is meant for one process at a time. */
+class CycleCache {
+public:
+  explicit CycleCache(size_t capacity = 1024);
+  ~CycleCache();
+  CycleCache(const CycleCache &) = delete;
+  CycleCache &operator=(const CycleCache &) = delete;
+
+  /* Opens or creates the store, a file of another format or size is
+   * started over */
+  bool openStore(const char *path, uint32_t slots = 1 << 13);
+
+  bool find(const CycleKey &key, CycleEntry &entry);
+  void insert(const CycleKey &key, const CycleEntry &entry);
+
+  /* Statistics */
+  uint64_t hits = 0;
+  uint64_t storeHits = 0; /* Of the hits, found in the store only */
+  uint64_t misses = 0;
+
+private:
+  struct KeyHash {
+    size_t operator()(const CycleKey &key) const { return key.hash; }
+  };
+  using Entries = std::list<std::pair<CycleKey, CycleEntry>>;
+
+  void remember(const CycleKey &key, const CycleEntry &entry);
+  bool findStored(const CycleKey &key, CycleEntry &entry) const;
+  void store(const CycleKey &key, const CycleEntry &entry);
+  void closeStore();
+
+  std::mutex mutex;
+  size_t capacity;
+  Entries entries; /* Most recently used first */
+  std::unordered_map<CycleKey, Entries::iterator, KeyHash> index;
+
+  uint8_t *map = nullptr;
+  size_t mapSize = 0;
+  uint32_t slots = 0;
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "Sweep.hpp"
+#include "CycleCache.hpp"
+#include "CycleStats.hpp"
+#include "SteadyState.hpp"
+#include "WorkStealingScheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool parseAxis(const char *text, SweepAxis &axis) {
+  float min, max;
+  int count;
+  if (sscanf(text, "%f:%f:%d", &min, &max, &count) == 3) {
+    axis = {min, max, count};
+    return count > 0;
+  }
+  if (sscanf(text, "%f", &min) == 1) {
+    axis = {min, min, 1};
+    return true;
+  }
+  return false;
+}
+
+size_t SweepGrid::size() const {
+  return static_cast<size_t>(throttle.count) * speed.count *
+         combustionAdvance.count * kexpl.count;
+}
+
+OperatingPoint SweepGrid::point(size_t index) const {
+  const int t = index % throttle.count;
+  index /= throttle.count;
+  const int s = index % speed.count;
+  index /= speed.count;
+  const int a = index % combustionAdvance.count;
+  index /= combustionAdvance.count;
+  const int k = index;
+
+  return OperatingPoint{.throttle = throttle.at(t),
+                        .speed = speed.at(s),
+                        .combustionAdvance = combustionAdvance.at(a),
+                        .kexpl = kexpl.at(k)};
+}
+
+Piston pointPiston(const CylinderGeometry &geometry,
+                   const OperatingPoint &point) {
+  Piston piston(geometry);
+  piston.throttle = point.throttle;
+  piston.combustionAdvance = point.combustionAdvance;
+  piston.kexpl = point.kexpl;
+  piston.ignitionOn = true;
+  piston.dynamicsIsActive = false;
+  piston.omega = point.speed;
+  return piston;
+}
+
+Piston pointPiston(const Piston &calibration, const OperatingPoint &point) {
+  Piston piston = pointPiston(calibration.getGeometry(), point);
+  piston.setCam(calibration.getCam());
+  piston.minThrottle = calibration.minThrottle;
+  piston.thermalK = calibration.thermalK;
+  piston.intakeCoef = calibration.intakeCoef;
+  piston.exhaustCoef = calibration.exhaustCoef;
+  piston.ignitionOn = calibration.ignitionOn;
+  return piston;
+}
+
+CycleResult simulatePoint(const CylinderGeometry &geometry,
+                          const OperatingPoint &point,
+                          const SweepSettings &settings) {
+  return simulatePiston(pointPiston(geometry, point), point.speed, settings);
+}
+
+/* Mean of every bin, empty bins (fast engine, long steps) hold the previous
+ * one */
+static void fillProfile(float *bins, const int *counts) {
+  float last = 0.f;
+  for (int i = 0; i < PROFILE_POINTS; ++i) {
+    if (counts[i] > 0) {
+      last = bins[i] / counts[i];
+      break;
+    }
+  }
+  for (int i = 0; i < PROFILE_POINTS; ++i) {
+    last = (counts[i] > 0) ? bins[i] / counts[i] : last;
+    bins[i] = last;
+  }
+}
+
+CycleResult simulatePiston(Piston piston, float speed,
+                           const SweepSettings &settings,
+                           CycleProfile *profile) {
+  constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+  CycleResult result = {NaN, NaN, NaN, NaN, NaN, NaN, NaN, NaN, 0};
+  if (profile != nullptr) {
+    *profile = {};
+  }
+  if (speed <= 0.f || settings.measuredCycles <= 0) {
+    return result;
+  }
+
+  const float fixedStep = 1.f / settings.substepRate;
+  AdaptiveStepper stepper(settings.stepTolerance);
+  const int cycles = settings.warmupCycles + settings.measuredCycles;
+
+  /* Two crankshaft turns per cycle, with margin for the partial first one */
+  const double maxTime = (cycles + 2) * 4 * std::numbers::pi / speed;
+
+  int cycle = -1; /* The first trigger ends the partial start-up cycle */
+  int warmup = settings.warmupCycles;
+  SteadyStateTracker tracker({.tolerance = settings.steadyTolerance,
+                              .maxCycles = settings.warmupCycles});
+  CycleStats stats;
+  double torque = 0.0;
+  double time = 0.0;
+  float peakPressure = 0.f;
+  double trappedMass = 0.0;
+  double heat = 0.0;
+  double intake = 0.0;      /* [J/K] of nR */
+  double outflow = 0.0;     /* [J/K] of nR */
+  double outflowHeat = 0.0; /* Outflow times its temperature */
+  int counts[PROFILE_POINTS] = {};
+
+  for (double elapsed = 0.0;
+       elapsed < maxTime && cycle < warmup + settings.measuredCycles;) {
+    float deltaT = fixedStep;
+    if (settings.adaptive) {
+      deltaT = stepper.step(piston, settings.stepTolerance.maxStep, speed);
+    } else {
+      piston.updatePosition(deltaT, speed);
+    }
+    elapsed += deltaT;
+    stats.update(piston, piston.getTorque(), deltaT);
+    if (profile != nullptr && cycle + 1 == warmup + settings.measuredCycles) {
+      const int bin = std::clamp(static_cast<int>(piston.headAngle), 0,
+                                 PROFILE_POINTS - 1);
+      profile->pressure[bin] += piston.gas.getP();
+      profile->temperature[bin] += piston.gas.getT();
+      profile->torque[bin] += piston.getTorque();
+      ++counts[bin];
+    }
+    if (settings.untilSteady && cycle < warmup) {
+      tracker.update(piston);
+    }
+    if (cycle >= warmup) {
+      /* Flows are the nR change of the step, out of the cylinder negative */
+      intake += std::max(piston.intakeFlow, 0.f);
+      outflow += std::max(-piston.exhaustFlow, 0.f);
+      outflowHeat += std::max(-piston.exhaustFlow, 0.f) * piston.gas.getT();
+    }
+    if (!piston.cycleTrigger) {
+      continue;
+    }
+    piston.cycleTrigger = false;
+    stats.endCycle();
+
+    /* Settled within this cycle, the next one is measured */
+    if (++cycle <= warmup &&
+        tracker.report().status == SteadyStatus::Converged) {
+      warmup = cycle;
+    } else if (cycle > warmup) {
+      const CycleSummary &s = stats.report().last;
+      torque += s.torque * s.duration;
+      time += s.duration;
+      peakPressure = std::max(peakPressure, s.peakPressure);
+      trappedMass += s.trappedMass;
+      heat += s.heatRelease;
+    }
+  }
+
+  result.warmupCycles = warmup;
+  if (cycle < warmup + settings.measuredCycles || time == 0.0) {
+    return result;
+  }
+
+  const int n = settings.measuredCycles;
+  result.torque = torque / time;
+  result.power = result.torque * speed;
+  result.peakPressure = peakPressure;
+  result.trappedMass = trappedMass / n;
+  result.fuelMass = heat / n / FUEL_LHV;
+  result.airflow = NRToKG(intake) / time;
+  result.exhaustTemperature = (outflow > 0) ? outflowHeat / outflow : NaN;
+
+  /* Work over one cycle is torque times two turns */
+  const double work = result.torque * 4 * std::numbers::pi; /* [J] */
+  result.bsfc = (work > 0) ? 1000.0 * result.fuelMass / (work / 3.6e6) : NaN;
+
+  if (profile != nullptr) {
+    fillProfile(profile->pressure, counts);
+    fillProfile(profile->temperature, counts);
+    fillProfile(profile->torque, counts);
+  }
+  return result;
+}
+
+std::vector<CycleResult> runSweep(const CylinderGeometry &geometry,
+                                  const SweepGrid &grid,
+                                  const SweepSettings &settings,
+                                  unsigned threads, CycleCache *cache) {
+  Piston calibration(geometry);
+  calibration.ignitionOn = true;
+  return runSweep(calibration, grid, settings, threads, cache);
+}
+
+std::vector<CycleResult> runSweep(const Piston &calibration,
+                                  const SweepGrid &grid,
+                                  const SweepSettings &settings,
+                                  unsigned threads, CycleCache *cache) {
+  std::vector<CycleResult> results(grid.size());
+
+  WorkStealingScheduler scheduler(threads);
+  scheduler.run(grid.size(), [&](size_t i) {
+    const OperatingPoint point = grid.point(i);
+    const Piston piston = pointPiston(calibration, point);
+    if (cache == nullptr) {
+      results[i] = simulatePiston(piston, point.speed, settings);
+      return;
+    }
+
+    const CycleKey key = CycleKey::of(piston, point.speed, settings);
+    CycleEntry entry;
+    if (!cache->find(key, entry)) {
+      entry.result =
+          simulatePiston(piston, point.speed, settings, &entry.profile);
+      cache->insert(key, entry);
+    }
+    results[i] = entry.result;
+  });
+
+  return results;
+}
+
+void writeTable(FILE *out, const SweepGrid &grid,
+                const std::vector<CycleResult> &results) {
+  fprintf(out, "throttle,speed_rpm,advance_deg,kexpl,torque_nm,power_w,"
+               "peak_pressure_atm,trapped_mass_mg,fuel_mg,bsfc_g_kwh,"
+               "airflow_g_s,exhaust_temp_k,warmup_cycles\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const OperatingPoint p = grid.point(i);
+    const CycleResult &r = results[i];
+    fprintf(out, "%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%d\n", p.throttle,
+            RADSToRPM(p.speed), p.combustionAdvance, p.kexpl, r.torque,
+            r.power, PAToATM(r.peakPressure), r.trappedMass * 1e6,
+            r.fuelMass * 1e6, r.bsfc, r.airflow * 1e3, r.exhaustTemperature,
+            r.warmupCycles);
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+#include "AdaptiveStepper.hpp"
+#include "Piston.hpp"
+#include <cstdio>
+#include <vector>
+
+constexpr float FUEL_LHV = 44e6f; /* Lower heating value of gasoline [J/kg] */
+
+/* count evenly spaced values in [min, max] */
+struct SweepAxis {
+  float min;
+  float max;
+  int count;
+
+  float at(int i) const {
+    return (count > 1) ? min + (max - min) * i / (count - 1) : min;
+  }
+  bool operator==(const SweepAxis &) const = default;
+};
+
+/* "min:max:count" or a single value, false if text is neither */
+bool parseAxis(const char *text, SweepAxis &axis);
+
+/* Speed-controlled operating point (dynamicsIsActive = false) */
+struct OperatingPoint {
+  float throttle;
+  float speed; /* [rad/s] */
+  float combustionAdvance;
+  float kexpl;
+};
+
+/* Averages over the measured cycles */
+struct CycleResult {
+  float torque;       /* [Nm] */
+  float power;        /* [W] */
+  float peakPressure; /* [Pa] */
+  float trappedMass;  /* At compression TDC [kg] */
+  float fuelMass;     /* Heat released / FUEL_LHV, per cycle [kg] */
+  float bsfc;         /* [g/kWh], NaN without positive work */
+  float airflow;      /* Intake mass flow [kg/s] */
+  float exhaustTemperature; /* Mean of the outflow [K] */
+  int warmupCycles;         /* Run before measuring */
+};
+
+/* One cycle resolved per head crank degree, i.e. two crank degrees */
+constexpr int PROFILE_POINTS = 360;
+struct CycleProfile {
+  float pressure[PROFILE_POINTS];    /* [Pa] */
+  float temperature[PROFILE_POINTS]; /* [K] */
+  float torque[PROFILE_POINTS];      /* [Nm] */
+};
+
+struct SweepGrid {
+  SweepAxis throttle;
+  SweepAxis speed;
+  SweepAxis combustionAdvance;
+  SweepAxis kexpl;
+
+  size_t size() const;
+  /* Throttle varies fastest, kexpl slowest */
+  OperatingPoint point(size_t index) const;
+};
+
+struct SweepSettings {
+  int warmupCycles = 10; /* At most, with untilSteady */
+  int measuredCycles = 2;
+  float substepRate = 1e4f; /* [Hz] */
+  /* Error controlled steps under stepTolerance instead of substepRate, see
+   * AdaptiveStepper */
+  bool adaptive = false;
+  StepTolerance stepTolerance;
+  /* Ends the warm-up once the cycles settle, see SteadyStateTracker */
+  bool untilSteady = false;
+  float steadyTolerance = 2e-3f;
+
+  bool operator==(const SweepSettings &) const = default;
+};
+
+class CycleCache;
+
+/* The piston of an operating point, calibrated with the Piston defaults */
+Piston pointPiston(const CylinderGeometry &geometry,
+                   const OperatingPoint &point);
+/* Same from a fresh start, with the geometry, cam and calibration of
+ * another piston: valve and thermal coefficients, minimum throttle and
+ * ignition */
+Piston pointPiston(const Piston &calibration, const OperatingPoint &point);
+
+CycleResult simulatePoint(const CylinderGeometry &geometry,
+                          const OperatingPoint &point,
+                          const SweepSettings &settings);
+
+/* Runs a configured piston at speed, profile gets the last measured cycle
+ * if given */
+CycleResult simulatePiston(Piston piston, float speed,
+                           const SweepSettings &settings,
+                           CycleProfile *profile = nullptr);
+
+/* Evaluates every grid point, spread over threads with work stealing. Points
+ * found in the cache are not simulated again, the others are added. */
+std::vector<CycleResult> runSweep(const CylinderGeometry &geometry,
+                                  const SweepGrid &grid,
+                                  const SweepSettings &settings,
+                                  unsigned threads,
+                                  CycleCache *cache = nullptr);
+/* Same around a calibrated piston, see pointPiston() */
+std::vector<CycleResult> runSweep(const Piston &calibration,
+                                  const SweepGrid &grid,
+                                  const SweepSettings &settings,
+                                  unsigned threads,
+                                  CycleCache *cache = nullptr);
+
+/* One CSV row per grid point, in grid order */
+void writeTable(FILE *out, const SweepGrid &grid,
+                const std::vector<CycleResult> &results);
+
+#endif
@@ -0,0 +1,59 @@
+#include "WorkStealingScheduler.hpp"
+#include <thread>
+
+WorkStealingScheduler::WorkStealingScheduler(unsigned threads)
+    : threads{threads > 0 ? threads : 1}, workers(this->threads) {}
+
+void WorkStealingScheduler::run(size_t count,
+                                const std::function<void(size_t)> &task) {
+  /* Contiguous blocks keep neighbouring grid points on the same thread */
+  for (size_t w = 0; w < workers.size(); ++w) {
+    const size_t begin = count * w / workers.size();
+    const size_t end = count * (w + 1) / workers.size();
+    for (size_t i = begin; i < end; ++i) {
+      workers[w].tasks.push_back(i);
+    }
+  }
+
+  std::vector<std::thread> pool;
+  for (size_t w = 1; w < workers.size(); ++w) {
+    pool.emplace_back(&WorkStealingScheduler::work, this, w, std::cref(task));
+  }
+  work(0, task);
+
+  for (std::thread &t : pool) {
+    t.join();
+  }
+}
+
+bool WorkStealingScheduler::pop(size_t self, size_t &task) {
+  Worker &worker = workers[self];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tasks.empty()) {
+    return false;
+  }
+  task = worker.tasks.back();
+  worker.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingScheduler::steal(size_t self, size_t &task) {
+  for (size_t i = 1; i < workers.size(); ++i) {
+    Worker &victim = workers[(self + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.front();
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingScheduler::work(size_t self,
+                                 const std::function<void(size_t)> &task) {
+  size_t index;
+  while (pop(self, index) || steal(self, index)) {
+    task(index);
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef WORKSTEALINGSCHEDULER_HPP
+#define WORKSTEALINGSCHEDULER_HPP
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/* Runs independent, unevenly sized tasks on a set of threads. Every worker
+ * owns a deque seeded with a contiguous block of task indices; it pops from
+ * the back of its own deque and, once empty, steals from the front of the
+ * others. Tasks never spawn tasks, so the run ends when all deques drain. */
+class WorkStealingScheduler {
+public:
+  WorkStealingScheduler(unsigned threads);
+
+  unsigned getThreadCount() const { return threads; }
+
+  void run(size_t count, const std::function<void(size_t)> &task);
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+  };
+
+  bool pop(size_t self, size_t &task);
+  bool steal(size_t self, size_t &task);
+  void work(size_t self, const std::function<void(size_t)> &task);
+
+  unsigned threads;
+  std::vector<Worker> workers;
+};
+
+#endif
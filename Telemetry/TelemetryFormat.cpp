@@ -0,0 +1,149 @@
+#include "TelemetryFormat.hpp"
+#include <bit>
+
+/* Samples are compressed as integers: the bit pattern of a float grows
+ * monotonically with its value within a sign, so linear extrapolation of the
+ * previous two patterns predicts smooth channels within a few ulps. The
+ * zigzag encoded prediction error is stored as:
+ *   0                     exact prediction
+ *   10 <len bits>         error fits the current bit length
+ *   11 <len-1:5> <bits>   new bit length
+ * Working on the bit patterns keeps the round trip exact, NaNs included. */
+
+namespace {
+
+class BitWriter {
+public:
+  BitWriter(uint8_t *out) : out{out}, acc{0}, bits{0} {}
+
+  /* n <= 32, full 32 bit words are stored big endian */
+  void write(uint32_t value, int n) {
+    acc = (acc << n) | (value & (~0ull >> (64 - n)));
+    bits += n;
+    if (bits >= 32) {
+      bits -= 32;
+      const uint32_t word = static_cast<uint32_t>(acc >> bits);
+      out[0] = static_cast<uint8_t>(word >> 24);
+      out[1] = static_cast<uint8_t>(word >> 16);
+      out[2] = static_cast<uint8_t>(word >> 8);
+      out[3] = static_cast<uint8_t>(word);
+      out += 4;
+    }
+  }
+
+  uint8_t *flush() {
+    while (bits >= 8) {
+      bits -= 8;
+      *out++ = static_cast<uint8_t>(acc >> bits);
+    }
+    if (bits > 0) {
+      *out++ = static_cast<uint8_t>(acc << (8 - bits));
+      bits = 0;
+    }
+    return out;
+  }
+
+private:
+  uint8_t *out;
+  uint64_t acc;
+  int bits;
+};
+
+class BitReader {
+public:
+  BitReader(const uint8_t *data, size_t size)
+      : data{data}, end{data + size}, acc{0}, bits{0} {}
+
+  /* n <= 32 */
+  uint32_t read(int n) {
+    while (bits < n) {
+      acc = (acc << 8) | ((data < end) ? *data : 0);
+      ++data;
+      bits += 8;
+    }
+    bits -= n;
+    return static_cast<uint32_t>(acc >> bits) & (~0u >> (32 - n));
+  }
+
+private:
+  const uint8_t *data;
+  const uint8_t *end;
+  uint64_t acc;
+  int bits;
+};
+
+inline uint32_t zigzag(uint32_t x) {
+  const int32_t i = static_cast<int32_t>(x);
+  return (static_cast<uint32_t>(i) << 1) ^ static_cast<uint32_t>(i >> 31);
+}
+
+inline uint32_t unzigzag(uint32_t z) { return (z >> 1) ^ (0u - (z & 1)); }
+
+} // namespace
+
+void encodeColumn(const float *v, size_t n, std::vector<uint8_t> &out) {
+  if (n == 0) {
+    return;
+  }
+
+  /* Worst case is 39 bits per sample */
+  const size_t start = out.size();
+  out.resize(start + 4 + n * 5);
+  BitWriter writer(out.data() + start);
+
+  uint32_t p1 = std::bit_cast<uint32_t>(v[0]);
+  uint32_t p2 = p1;
+  writer.write(p1, 32);
+
+  int len = 32;
+  for (size_t i = 1; i < n; ++i) {
+    const uint32_t value = std::bit_cast<uint32_t>(v[i]);
+    const uint32_t z = zigzag(value - (2 * p1 - p2));
+    p2 = p1;
+    p1 = value;
+
+    if (z == 0) {
+      writer.write(0, 1);
+      continue;
+    }
+
+    /* Keep the current length unless it wastes more than a few bits */
+    const int bits = 32 - std::countl_zero(z);
+    if (bits <= len && bits > len - 4) {
+      writer.write(0b10, 2);
+    } else {
+      len = bits;
+      writer.write((0b11 << 5) | (len - 1), 7);
+    }
+    writer.write(z, len);
+  }
+
+  out.resize(writer.flush() - out.data());
+}
+
+void decodeColumn(const uint8_t *data, size_t size, size_t n, float *v) {
+  if (n == 0) {
+    return;
+  }
+
+  BitReader reader(data, size);
+  uint32_t p1 = reader.read(32);
+  uint32_t p2 = p1;
+  v[0] = std::bit_cast<float>(p1);
+
+  int len = 32;
+  for (size_t i = 1; i < n; ++i) {
+    uint32_t z = 0;
+    if (reader.read(1) != 0) {
+      if (reader.read(1) != 0) {
+        len = reader.read(5) + 1;
+      }
+      z = reader.read(len);
+    }
+
+    const uint32_t value = 2 * p1 - p2 + unzigzag(z);
+    p2 = p1;
+    p1 = value;
+    v[i] = std::bit_cast<float>(value);
+  }
+}
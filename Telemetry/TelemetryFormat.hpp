@@ -0,0 +1,32 @@
+#ifndef TELEMETRYFORMAT_HPP
+#define TELEMETRYFORMAT_HPP
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Telemetry file layout, headers little endian through the checkpoint
+ * archives, see Checkpoint.hpp:
+ *
+ *   header  "ESTL", u32 version, u32 channels, f32 deltaT,
+ *           then per channel: u16 name length, name bytes
+ *   block   "BLK0", u32 samples, u32 payload size of every channel,
+ *           then the channel payloads one after the other
+ *
+ * Blocks repeat until the end of the file. Every channel payload is an
+ * independent delta-of-delta stream, so a reader can decode a single column
+ * of a single block. Payloads are bit streams, most significant bit first,
+ * whatever the host. */
+
+constexpr uint32_t TELEMETRY_MAGIC = 0x4c545345;  /* "ESTL" */
+constexpr uint32_t TELEMETRY_BLOCK = 0x304b4c42;  /* "BLK0" */
+constexpr uint32_t TELEMETRY_VERSION = 1;
+constexpr int TELEMETRY_MAX_CHANNELS = 16;
+constexpr int TELEMETRY_BLOCK_FRAMES = 4096;
+
+/* Appends the compressed form of n samples to out */
+void encodeColumn(const float *v, size_t n, std::vector<uint8_t> &out);
+
+/* Decodes n samples from a payload written by encodeColumn */
+void decodeColumn(const uint8_t *data, size_t size, size_t n, float *v);
+
+#endif
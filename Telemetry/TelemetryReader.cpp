@@ -0,0 +1,122 @@
+#include "TelemetryReader.hpp"
+#include "Checkpoint.hpp"
+#include "TelemetryFormat.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TelemetryReader::TelemetryReader(const char *path)
+    : data{nullptr}, size{0}, deltaT{0}, sampleCount{0} {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      data = static_cast<const uint8_t *>(map);
+      size = st.st_size;
+    }
+  }
+  ::close(fd);
+
+  if (data != nullptr && !parse()) {
+    munmap(const_cast<uint8_t *>(data), size);
+    data = nullptr;
+    size = 0;
+  }
+}
+
+TelemetryReader::~TelemetryReader() {
+  if (data != nullptr) {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+}
+
+bool TelemetryReader::parse() {
+  CheckpointReader archive({data, size});
+  uint32_t magic = 0, version = 0, count = 0;
+  archive(magic, version, count, deltaT);
+  if (!archive.isValid() || magic != TELEMETRY_MAGIC ||
+      version != TELEMETRY_VERSION || count == 0 ||
+      count > TELEMETRY_MAX_CHANNELS) {
+    return false;
+  }
+
+  channels.resize(count);
+  for (std::string &name : channels) {
+    uint16_t length = 0;
+    archive(length);
+    const std::span<const uint8_t> bytes = archive.bytes(length);
+    if (!archive.isValid()) {
+      return false;
+    }
+    name.assign(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  }
+
+  /* A truncated trailing block, e.g. from a crashed run, is ignored */
+  while (!archive.isComplete()) {
+    uint32_t blockMagic = 0, samples = 0;
+    BlockIndex block;
+    block.size.resize(channels.size());
+    archive(blockMagic, samples);
+    for (uint32_t &s : block.size) {
+      archive(s);
+    }
+    if (!archive.isValid() || blockMagic != TELEMETRY_BLOCK) {
+      break;
+    }
+
+    block.firstSample = sampleCount;
+    block.samples = samples;
+    for (uint32_t s : block.size) {
+      block.offset.push_back(archive.bytes(s).data() - data);
+    }
+    if (!archive.isValid()) {
+      break;
+    }
+
+    sampleCount += block.samples;
+    blocks.push_back(std::move(block));
+  }
+  return true;
+}
+
+int TelemetryReader::findChannel(const std::string &name) const {
+  const auto it = std::find(channels.begin(), channels.end(), name);
+  return (it != channels.end()) ? static_cast<int>(it - channels.begin()) : -1;
+}
+
+void TelemetryReader::read(int channel, uint64_t first, uint64_t count,
+                           std::vector<float> &out) const {
+  out.clear();
+  if (channel < 0 || channel >= getChannelCount() || first >= sampleCount) {
+    return;
+  }
+  count = std::min(count, sampleCount - first);
+  out.reserve(count);
+
+  std::vector<float> scratch(TELEMETRY_BLOCK_FRAMES);
+  const uint64_t last = first + count;
+  for (const BlockIndex &block : blocks) {
+    const uint64_t end = block.firstSample + block.samples;
+    if (end <= first) {
+      continue;
+    }
+    if (block.firstSample >= last) {
+      break;
+    }
+
+    scratch.resize(block.samples);
+    decodeColumn(data + block.offset[channel], block.size[channel],
+                 block.samples, scratch.data());
+
+    const uint64_t from = std::max(first, block.firstSample) - block.firstSample;
+    const uint64_t to = std::min(last, end) - block.firstSample;
+    out.insert(out.end(), scratch.begin() + from, scratch.begin() + to);
+  }
+}
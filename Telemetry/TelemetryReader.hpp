@@ -0,0 +1,56 @@
+#ifndef TELEMETRYREADER_HPP
+#define TELEMETRYREADER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Read-only view of a telemetry file, mapped in memory. Blocks are indexed
+ * on open and decoded on demand, one channel at a time. */
+class TelemetryReader {
+public:
+  TelemetryReader(const char *path);
+  ~TelemetryReader();
+
+  TelemetryReader(const TelemetryReader &) = delete;
+  TelemetryReader &operator=(const TelemetryReader &) = delete;
+
+  bool isOpen() const { return data != nullptr; }
+
+  int getChannelCount() const { return static_cast<int>(channels.size()); }
+  const std::string &getChannelName(int channel) const {
+    return channels[channel];
+  }
+  /* Index of the named channel, -1 if missing */
+  int findChannel(const std::string &name) const;
+
+  float getDeltaT() const { return deltaT; }
+  uint64_t getSampleCount() const { return sampleCount; }
+  size_t getFileSize() const { return size; }
+
+  /* Decodes samples [first, first + count) of a channel into out */
+  void read(int channel, uint64_t first, uint64_t count,
+            std::vector<float> &out) const;
+  void read(int channel, std::vector<float> &out) const {
+    read(channel, 0, sampleCount, out);
+  }
+
+private:
+  struct BlockIndex {
+    uint64_t firstSample;
+    uint32_t samples;
+    std::vector<size_t> offset; /* Payload of each channel */
+    std::vector<uint32_t> size;
+  };
+
+  bool parse();
+
+  const uint8_t *data;
+  size_t size;
+  float deltaT;
+  uint64_t sampleCount;
+  std::vector<std::string> channels;
+  std::vector<BlockIndex> blocks;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "TelemetryWriter.hpp"
+#include "Checkpoint.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+
+TelemetryWriter::TelemetryWriter(const char *path,
+                                 const std::vector<std::string> &channels,
+                                 float deltaT)
+    : file{nullptr}, channelCount{static_cast<int>(channels.size())},
+      pool(POOL_SIZE), current{nullptr}, dropped{0}, running{false},
+      bytesWritten{0} {
+  if (channelCount == 0 || channelCount > TELEMETRY_MAX_CHANNELS) {
+    return;
+  }
+
+  file = fopen(path, "wb");
+  if (file == nullptr) {
+    return;
+  }
+
+  std::vector<uint8_t> header;
+  CheckpointWriter archive(header);
+  uint32_t magic = TELEMETRY_MAGIC;
+  uint32_t version = TELEMETRY_VERSION;
+  uint32_t count = static_cast<uint32_t>(channelCount);
+  archive(magic, version, count, deltaT);
+  for (const std::string &name : channels) {
+    uint16_t length = static_cast<uint16_t>(name.size());
+    archive(length);
+    archive.bytes({reinterpret_cast<const uint8_t *>(name.data()), length});
+  }
+  fwrite(header.data(), 1, header.size(), file);
+  bytesWritten = header.size();
+
+  for (Block &block : pool) {
+    block.frames = 0;
+    freeBlocks.push(&block);
+  }
+  column.resize(TELEMETRY_BLOCK_FRAMES);
+  sizes.resize(channelCount);
+  blockHeader.reserve(2 * sizeof(uint32_t) + sizes.size() * sizeof(uint32_t));
+
+  running = true;
+  thread = std::thread(&TelemetryWriter::loop, this);
+}
+
+TelemetryWriter::~TelemetryWriter() { close(); }
+
+bool TelemetryWriter::nextBlock() {
+  if (!freeBlocks.pop(current)) {
+    current = nullptr;
+    return false;
+  }
+  current->frames = 0;
+  return true;
+}
+
+void TelemetryWriter::close() {
+  if (file == nullptr) {
+    return;
+  }
+
+  if (current != nullptr && current->frames > 0) {
+    /* At most POOL_SIZE blocks exist, so there is always room */
+    filledBlocks.push(current);
+  }
+  current = nullptr;
+
+  running = false;
+  thread.join();
+
+  fclose(file);
+  file = nullptr;
+}
+
+void TelemetryWriter::loop() {
+  Block *block;
+  while (true) {
+    if (filledBlocks.pop(block)) {
+      writeBlock(*block);
+      freeBlocks.push(block);
+    } else if (running) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    } else if (filledBlocks.size() == 0) {
+      break;
+    }
+  }
+  fflush(file);
+}
+
+void TelemetryWriter::writeBlock(const Block &block) {
+  payload.clear();
+  for (int c = 0; c < channelCount; ++c) {
+    for (int i = 0; i < block.frames; ++i) {
+      column[i] = block.data[i * channelCount + c];
+    }
+    const size_t before = payload.size();
+    encodeColumn(column.data(), block.frames, payload);
+    sizes[c] = static_cast<uint32_t>(payload.size() - before);
+  }
+
+  blockHeader.clear();
+  CheckpointWriter archive(blockHeader);
+  uint32_t magic = TELEMETRY_BLOCK;
+  uint32_t frames = static_cast<uint32_t>(block.frames);
+  archive(magic, frames);
+  for (uint32_t &size : sizes) {
+    archive(size);
+  }
+  fwrite(blockHeader.data(), 1, blockHeader.size(), file);
+  fwrite(payload.data(), 1, payload.size(), file);
+  bytesWritten += blockHeader.size() + payload.size();
+}
+
+const std::vector<std::string> &simulationChannels() {
+  static const std::vector<std::string> channels = {
+      "head_angle",  "speed",  "position",    "pressure", "intake",
+      "exhaust",     "torque", "temperature", "oxygen"};
+  return channels;
+}
+
+void recordStep(TelemetryWriter &writer, const Simulation &sim) {
+  const SimSample &s = sim.sample;
+  const float frame[] = {sim.piston.headAngle,
+                         sim.piston.omega,
+                         s.position,
+                         s.pressure,
+                         s.intake,
+                         s.exhaust,
+                         s.torque,
+                         s.temperature,
+                         s.oxygen};
+  writer.record(frame);
+}
@@ -0,0 +1,91 @@
+#ifndef TELEMETRYWRITER_HPP
+#define TELEMETRYWRITER_HPP
+#include "SpscQueue.hpp"
+#include "TelemetryFormat.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Simulation;
+
+/* Streams fixed-size frames of float channels to a telemetry file.
+ * record() only copies the frame into a preallocated block; full blocks are
+ * handed to a background thread that compresses and writes them. When the
+ * writer falls behind, frames are dropped and counted instead of blocking
+ * the caller. */
+class TelemetryWriter {
+public:
+  TelemetryWriter(const char *path, const std::vector<std::string> &channels,
+                  float deltaT);
+  ~TelemetryWriter();
+
+  TelemetryWriter(const TelemetryWriter &) = delete;
+  TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+  bool isOpen() const { return file != nullptr; }
+
+  /* One sample per channel, in the order given to the constructor */
+  void record(const float *frame) {
+    if (current == nullptr && !nextBlock()) {
+      ++dropped;
+      return;
+    }
+    float *dst = current->data + current->frames * channelCount;
+    for (int c = 0; c < channelCount; ++c) {
+      dst[c] = frame[c];
+    }
+    if (++current->frames == TELEMETRY_BLOCK_FRAMES) {
+      filledBlocks.push(current);
+      current = nullptr;
+    }
+  }
+
+  /* Flushes the pending frames and closes the file, called by the dtor */
+  void close();
+
+  uint64_t getDropped() const { return dropped; }
+  uint64_t getBytesWritten() const { return bytesWritten.load(); }
+
+private:
+  static constexpr size_t POOL_SIZE = 16;
+
+  /* Row major frames, transposed to columns by the writer thread */
+  struct Block {
+    int frames;
+    float data[TELEMETRY_BLOCK_FRAMES * TELEMETRY_MAX_CHANNELS];
+  };
+
+  bool nextBlock();
+  void loop();
+  void writeBlock(const Block &block);
+
+  FILE *file;
+  int channelCount;
+
+  std::vector<Block> pool;
+  SpscQueue<Block *, POOL_SIZE> freeBlocks;   /* Writer thread to producer */
+  SpscQueue<Block *, POOL_SIZE> filledBlocks; /* Producer to writer thread */
+  Block *current;
+  uint64_t dropped;
+
+  std::thread thread;
+  std::atomic<bool> running;
+  std::atomic<uint64_t> bytesWritten;
+
+  /* Writer thread scratch */
+  std::vector<float> column;
+  std::vector<uint8_t> payload;
+  std::vector<uint32_t> sizes;
+  std::vector<uint8_t> blockHeader; /* Serialized, see TelemetryFormat.hpp */
+};
+
+/* Channels recorded by recordStep, in frame order */
+const std::vector<std::string> &simulationChannels();
+
+/* Records the state of a Simulation after a step */
+void recordStep(TelemetryWriter &writer, const Simulation &sim);
+
+#endif
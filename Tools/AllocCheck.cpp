@@ -0,0 +1,196 @@
+#include "Decimator.hpp"
+#include "EngineSound.hpp"
+#include "FrameRVis.hpp"
+#include "SimThread.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include <thread>
+
+/* Runs the frontend hot paths headless, the simulation thread with the
+ * engine sound, and a render loop doing everything main.cpp does per frame
+ * but the drawing, under a counting allocator. After the warm-up any heap
+ * allocation, from any thread, fails the check: steady state must not
+ * allocate. Exits with 1 if it did. */
+
+static std::atomic<bool> counting{false};
+static std::atomic<uint64_t> allocations{0};
+static std::atomic<uint64_t> allocatedBytes{0};
+
+static void *countedAlloc(size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new(size_t size) { return countedAlloc(size); }
+void *operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+struct Settings {
+  double warmup = 2.0;   /* [s] */
+  double duration = 5.0; /* [s] checked */
+  float frameTime = 0.02f;
+  int substeps = 200;
+  bool adaptive = false;
+  bool dynamics = false;
+  /* Move the throttle every frame and slow the engine down while checked,
+   * every cycle longer than any before */
+  bool commands = true;
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --warmup <s>        untracked start (default 2)\n"
+          "  --duration <s>      tracked time (default 5)\n"
+          "  --frame <ms>        frame and tick period (default 20)\n"
+          "  --substeps <n>      steps per tick (default 200)\n"
+          "  --adaptive          adaptive step\n"
+          "  --dynamics          integrate the crankshaft speed\n"
+          "  --no-commands       leave the inputs alone\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Settings &s) {
+  bool ok = true;
+  for (int i = 1; ok && i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--adaptive") {
+      s.adaptive = true;
+    } else if (arg == "--dynamics") {
+      s.dynamics = true;
+    } else if (arg == "--no-commands") {
+      s.commands = false;
+    } else if (hasValue && arg == "--warmup") {
+      s.warmup = atof(argv[++i]);
+    } else if (hasValue && arg == "--duration") {
+      s.duration = atof(argv[++i]);
+    } else if (hasValue && arg == "--frame") {
+      s.frameTime = atof(argv[++i]) / 1000;
+    } else if (hasValue && arg == "--substeps") {
+      s.substeps = atoi(argv[++i]);
+    } else {
+      ok = false;
+    }
+  }
+  return ok && s.warmup >= 0 && s.duration > 0 && s.frameTime > 0 &&
+         s.substeps > 0;
+}
+
+/* Stand-in for the plots of main.cpp */
+struct Plots {
+  DecimatedSeries torque{Decimation::MinMax};
+  DecimatedSeries oxygen{Decimation::Lttb};
+  DecimatedSeries pressure{Decimation::MinMax};
+  DecimatedSeries temperature{Decimation::Lttb};
+  DecimatedSeries intake{Decimation::Lttb};
+  DecimatedSeries exhaust{Decimation::Lttb};
+
+  void update(const SimSnapshot &snap, int points) {
+    const CycleTraces &c = snap.cycle;
+    const uint64_t id = snap.cycleCount;
+    torque.update(c.torque, id, points);
+    oxygen.update(c.oxygen, id, points);
+    pressure.update(c.pressure, id, points);
+    temperature.update(c.temperature, id, points);
+    intake.update(c.intake, id, points);
+    exhaust.update(c.exhaust, id, points);
+  }
+};
+
+int main(int argc, char *argv[]) {
+  Settings settings;
+  if (!parseArgs(argc, argv, settings)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  constexpr int DEVICE_RATE = 48000;
+  constexpr int DEVICE_BUFFER = 256;
+  constexpr float START_SPEED = 100.f; /* [rad/s] */
+  static float audio[DEVICE_RATE];
+
+  Simulation sim{CylinderGeometry()};
+  sim.engineSpeed = START_SPEED;
+  sim.piston.omega = START_SPEED;
+  sim.piston.ignitionOn = true;
+  sim.piston.dynamicsIsActive = settings.dynamics;
+  sim.adaptive = settings.adaptive;
+  EngineSound sound(DEVICE_RATE, DEVICE_BUFFER);
+  sim.onStep = [&](float deltaT) { sound.push(sim.piston, deltaT); };
+
+  SimThread simThread(sim, settings.frameTime, settings.substeps);
+  FrameRVis frames;
+  Plots plots;
+  const int audioFrames = static_cast<int>(settings.frameTime * DEVICE_RATE);
+
+  simThread.start();
+  const auto start = std::chrono::steady_clock::now();
+  auto next = start;
+  uint64_t frameCount = 0, checkedFrames = 0;
+  bool checking = false;
+  float throttle = 1.f;
+
+  for (;;) {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= settings.warmup + settings.duration) {
+      break;
+    }
+    if (!checking && elapsed.count() >= settings.warmup) {
+      counting = true;
+      checking = true;
+    }
+
+    frames.startClock();
+    const SimSnapshot &snap = simThread.snapshot();
+    plots.update(snap, 1000);
+    if (settings.commands) {
+      throttle = (throttle > 0.5f) ? 0.49f : 1.f;
+      simThread.send({SimCommand::Throttle, throttle});
+      const double slowdown =
+          std::max(elapsed.count() - settings.warmup, 0.0) / settings.duration;
+      simThread.send({SimCommand::EngineSpeed,
+                      static_cast<float>(START_SPEED * (1 - 0.5 * slowdown))});
+    }
+    sound.render(audio, audioFrames);
+    frames.endClock();
+
+    ++frameCount;
+    checkedFrames += checking;
+    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(settings.frameTime));
+    std::this_thread::sleep_until(next);
+  }
+
+  counting = false;
+  simThread.stop();
+
+  const SimSnapshot &snap = simThread.snapshot();
+  printf("Frames:       %llu, %llu checked\n",
+         (unsigned long long)frameCount, (unsigned long long)checkedFrames);
+  printf("Simulated:    %.2f s, %llu steps, %llu cycles\n", snap.simTime,
+         (unsigned long long)snap.stepCount,
+         (unsigned long long)snap.cycleCount);
+  printf("Allocations:  %llu after the warm-up, %llu bytes\n",
+         (unsigned long long)allocations.load(),
+         (unsigned long long)allocatedBytes.load());
+  return allocations.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include "EngineSound.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+/* Runs the engine sound pipeline headless on a virtual clock: simulation
+ * ticks and audio callbacks interleave as they would in real time, SimThread
+ * producing a tick of steps at once, the device pulling fixed buffers. The
+ * output can go to a WAV file. */
+
+struct Settings {
+  double duration = 5.0;    /* [s] */
+  float substepRate = 1e4f; /* [Hz] */
+  float tick = 0.005f;      /* SimThread period with sound [s] */
+  float jitter = 0.f;       /* Maximum random tick delay [s] */
+  float engineSpeed = 300.f;
+  float throttle = 1.f;
+  int deviceRate = 48000;
+  int buffer = 128;
+  const char *wav = nullptr;
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --duration <s>      played time (default 5)\n"
+          "  --rate <Hz>         substep rate (default 10000)\n"
+          "  --tick <ms>         simulation tick (default 5, as the frontend\n"
+          "                      with sound)\n"
+          "  --jitter <ms>       random delay of every tick (default 0)\n"
+          "  --speed <rad/s>     set speed (default 300)\n"
+          "  --throttle <0..1>   throttle position (default 1)\n"
+          "  --device-rate <Hz>  output rate (default 48000)\n"
+          "  --buffer <n>        samples per callback (default 128)\n"
+          "  --wav <file>        write the output, 16 bit mono\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Settings &s) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    } else if (arg == "--duration") {
+      s.duration = atof(argv[++i]);
+    } else if (arg == "--rate") {
+      s.substepRate = atof(argv[++i]);
+    } else if (arg == "--tick") {
+      s.tick = atof(argv[++i]) / 1000;
+    } else if (arg == "--jitter") {
+      s.jitter = atof(argv[++i]) / 1000;
+    } else if (arg == "--speed") {
+      s.engineSpeed = atof(argv[++i]);
+    } else if (arg == "--throttle") {
+      s.throttle = atof(argv[++i]);
+    } else if (arg == "--device-rate") {
+      s.deviceRate = atoi(argv[++i]);
+    } else if (arg == "--buffer") {
+      s.buffer = atoi(argv[++i]);
+    } else if (arg == "--wav") {
+      s.wav = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return s.duration > 0 && s.substepRate > 0 && s.tick > 0 &&
+         s.jitter >= 0 && s.deviceRate > 0 && s.buffer > 0;
+}
+
+static bool writeWav(const char *path, const std::vector<float> &samples,
+                     int rate) {
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const uint32_t dataSize = samples.size() * sizeof(int16_t);
+  const uint32_t riffSize = 36 + dataSize;
+  const uint32_t fmtSize = 16, byteRate = rate * sizeof(int16_t);
+  const uint32_t sampleRate = rate;
+  const uint16_t pcm = 1, channels = 1, align = sizeof(int16_t), bits = 16;
+
+  fwrite("RIFF", 1, 4, file);
+  fwrite(&riffSize, 4, 1, file);
+  fwrite("WAVEfmt ", 1, 8, file);
+  fwrite(&fmtSize, 4, 1, file);
+  fwrite(&pcm, 2, 1, file);
+  fwrite(&channels, 2, 1, file);
+  fwrite(&sampleRate, 4, 1, file);
+  fwrite(&byteRate, 4, 1, file);
+  fwrite(&align, 2, 1, file);
+  fwrite(&bits, 2, 1, file);
+  fwrite("data", 1, 4, file);
+  fwrite(&dataSize, 4, 1, file);
+  for (float x : samples) {
+    const int16_t v = std::lround(std::clamp(x, -1.f, 1.f) * 32767);
+    fwrite(&v, sizeof(v), 1, file);
+  }
+  return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[]) {
+  Settings settings;
+  if (!parseArgs(argc, argv, settings)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Simulation sim{CylinderGeometry()};
+  sim.engineSpeed = settings.engineSpeed;
+  sim.piston.omega = settings.engineSpeed;
+  sim.piston.throttle = settings.throttle;
+  sim.piston.ignitionOn = true;
+  sim.piston.dynamicsIsActive = false;
+  sim.substeps =
+      std::max<int>(std::lround(settings.substepRate * settings.tick), 1);
+
+  auto *sound = new EngineSound(settings.deviceRate, settings.buffer);
+  sim.onStep = [&](float deltaT) { sound->push(sim.piston, deltaT); };
+
+  const double callbackPeriod =
+      static_cast<double>(settings.buffer) / settings.deviceRate;
+  const long callbacks = std::lround(settings.duration / callbackPeriod);
+  std::vector<float> output(static_cast<size_t>(callbacks) * settings.buffer);
+
+  /* Virtual clock: the next tick runs as soon as its start time is reached */
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> delay(0.f, settings.jitter);
+  uint64_t ticks = 0;
+  double nextTick = 0.0;
+  double latencySum = 0.0;
+  float latencyMax = 0.f;
+  long latencySamples = 0;
+
+  for (long i = 0; i < callbacks; ++i) {
+    const double now = i * callbackPeriod;
+    while (nextTick <= now) {
+      sim.tick(settings.tick);
+      ++ticks;
+      nextTick = ticks * settings.tick + delay(rng);
+    }
+    sound->render(&output[i * settings.buffer], settings.buffer);
+
+    /* The first second settles the fill control */
+    if (now >= 1.0) {
+      latencySum += sound->getLatency();
+      latencyMax = std::max(latencyMax, sound->getLatency());
+      ++latencySamples;
+    }
+  }
+
+  float peak = 0.f;
+  double power = 0.0;
+  for (float x : output) {
+    peak = std::max(peak, std::fabs(x));
+    power += static_cast<double>(x) * x;
+  }
+
+  printf("Played:           %.3f s at %d Hz, %d sample buffers\n",
+         callbacks * callbackPeriod, settings.deviceRate, settings.buffer);
+  printf("Steps:            %.0f Hz, %d per %.1f ms tick\n",
+         settings.substepRate, sim.substeps, settings.tick * 1e3f);
+  if (latencySamples > 0) {
+    printf("Latency:          %.2f ms mean, %.2f ms max\n",
+           latencySum / latencySamples * 1e3, latencyMax * 1e3f);
+    printf("Input to sound:   %.2f ms at worst, tick included\n",
+           (latencyMax + settings.tick + settings.jitter) * 1e3f);
+  }
+  printf("Underruns:        %llu callbacks\n",
+         (unsigned long long)sound->getUnderruns());
+  printf("Dropped frames:   %llu\n", (unsigned long long)sound->getDropped());
+  printf("Level:            %.3f peak, %.3f RMS\n", peak,
+         std::sqrt(power / output.size()));
+
+  if (settings.wav != nullptr &&
+      !writeWav(settings.wav, output, settings.deviceRate)) {
+    fprintf(stderr, "Cannot write %s\n", settings.wav);
+    return 1;
+  }
+  delete sound;
+  return 0;
+}
@@ -0,0 +1,274 @@
+#include "Engine.hpp"
+#include "EngineBatch.hpp"
+#include "Session.hpp"
+#include "Simulation.hpp"
+#include "TelemetryWriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+/* Runs a single scenario headless, as fast as the CPU allows */
+
+struct Scenario {
+  double duration = 10.0;  /* Simulated time [s] */
+  float substepRate = 1e4; /* [Hz] */
+  float engineSpeed = 100.f;
+  float throttle = 1.f;
+  float externalTorque = 0.f;
+  float combustionAdvance = 0.f;
+  bool ignition = true;
+  bool dynamics = false;
+  bool adaptive = false;
+  float tolerance = StepTolerance().relative;
+  int engines = 0; /* Lockstep copies stepped by EngineBatch */
+  int cylinders = 0; /* Multi-cylinder Engine instead of a single Piston */
+  unsigned threads = 1;
+  const char *record = nullptr;  /* Telemetry file */
+  const char *session = nullptr; /* Replayable session file */
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --duration <s>      simulated time (default 10)\n"
+          "  --rate <Hz>         substep rate (default 10000)\n"
+          "  --speed <rad/s>     set speed, initial speed with --dynamics\n"
+          "  --throttle <0..1>   throttle position (default 1)\n"
+          "  --torque <Nm>       external torque (default 0)\n"
+          "  --advance <deg>     combustion advance (default 0)\n"
+          "  --no-ignition       disable the spark plug\n"
+          "  --dynamics          integrate the crankshaft speed\n"
+          "  --adaptive          error controlled steps, --rate is ignored\n"
+          "  --tolerance <rel>   relative tolerance of --adaptive (default "
+          "1e-2)\n"
+          "  --batch <n>         step n copies in lockstep with EngineBatch\n"
+          "  --cylinders <n>     n cylinders on a shared crankshaft\n"
+          "  --threads <n>       worker threads for --cylinders (default 1)\n"
+          "  --record <file>     stream every step to a telemetry file\n"
+          "  --session <file>    record a session for the replay tool\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Scenario &s) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--no-ignition") {
+      s.ignition = false;
+    } else if (arg == "--dynamics") {
+      s.dynamics = true;
+    } else if (arg == "--adaptive") {
+      s.adaptive = true;
+    } else if (hasValue && arg == "--tolerance") {
+      s.tolerance = atof(argv[++i]);
+    } else if (hasValue && arg == "--duration") {
+      s.duration = atof(argv[++i]);
+    } else if (hasValue && arg == "--rate") {
+      s.substepRate = atof(argv[++i]);
+    } else if (hasValue && arg == "--speed") {
+      s.engineSpeed = atof(argv[++i]);
+    } else if (hasValue && arg == "--throttle") {
+      s.throttle = atof(argv[++i]);
+    } else if (hasValue && arg == "--torque") {
+      s.externalTorque = atof(argv[++i]);
+    } else if (hasValue && arg == "--advance") {
+      s.combustionAdvance = atof(argv[++i]);
+    } else if (hasValue && arg == "--batch") {
+      s.engines = atoi(argv[++i]);
+    } else if (hasValue && arg == "--cylinders") {
+      s.cylinders = atoi(argv[++i]);
+    } else if (hasValue && arg == "--threads") {
+      s.threads = atoi(argv[++i]);
+    } else if (hasValue && arg == "--record") {
+      s.record = argv[++i];
+    } else if (hasValue && arg == "--session") {
+      s.session = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return s.duration > 0 && s.substepRate > 0 && s.tolerance > 0 &&
+         s.engines >= 0 && s.cylinders >= 0 && s.threads > 0;
+}
+
+static int runEngine(const Scenario &scenario, const Piston &piston) {
+  Engine engine(piston.getGeometry(),
+                Engine::defaultFiringOrder(scenario.cylinders),
+                scenario.threads);
+  for (Piston &cylinder : engine.cylinders) {
+    cylinder.throttle = piston.throttle;
+    cylinder.combustionAdvance = piston.combustionAdvance;
+    cylinder.ignitionOn = piston.ignitionOn;
+  }
+  engine.dynamicsIsActive = scenario.dynamics;
+  engine.omega = scenario.engineSpeed;
+  engine.applyExtTorque(scenario.externalTorque);
+
+  const float deltaT = 1.f / scenario.substepRate;
+  const long steps = std::lround(scenario.duration / deltaT);
+  double torqueSum = 0.0;
+  long torqueSamples = 0;
+  double cycleTorque = 0.0;
+  uint64_t cycles = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < steps; ++i) {
+    engine.step(deltaT, scenario.engineSpeed);
+    torqueSum += engine.getTorque();
+    ++torqueSamples;
+
+    /* Average over the last complete cycle */
+    if (engine.cycleTrigger) {
+      cycleTorque = torqueSum / torqueSamples;
+      torqueSum = 0.0;
+      torqueSamples = 0;
+      engine.cycleTrigger = false;
+      ++cycles;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double wall = std::chrono::duration<double>(end - start).count();
+
+  printf("Cylinders:        %d\n", engine.getCylinderCount());
+  printf("Simulated time:   %.3f s\n", steps * deltaT);
+  printf("Wall time:        %.3f s\n", wall);
+  printf("Sim s / wall s:   %.1f\n", steps * deltaT / wall);
+  printf("Steps/s:          %.0f\n", steps / wall);
+  printf("Cycles:           %llu\n", (unsigned long long)cycles);
+  printf("Speed:            %.0f rpm\n", RADSToRPM(engine.omega));
+  printf("Output torque:    %.2f Nm\n", cycleTorque);
+  printf("Output power:     %.0f W\n", cycleTorque * engine.omega);
+  return 0;
+}
+
+static int runBatch(const Scenario &scenario, const Piston &piston) {
+  EngineBatch batch(scenario.engines, piston.getGeometry());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch.assign(i, piston);
+    batch.externalTorque[i] = scenario.externalTorque;
+    batch.setSpeed[i] = scenario.engineSpeed;
+  }
+
+  const float deltaT = 1.f / scenario.substepRate;
+  const long steps = std::lround(scenario.duration / deltaT);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < steps; ++i) {
+    batch.step(deltaT);
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double wall = std::chrono::duration<double>(end - start).count();
+  const double engineSteps = static_cast<double>(steps) * batch.size();
+
+  printf("Engines:          %zu\n", batch.size());
+  printf("Simulated time:   %.3f s\n", steps * deltaT);
+  printf("Wall time:        %.3f s\n", wall);
+  printf("Sim s / wall s:   %.1f\n", steps * deltaT / wall);
+  printf("Engine-steps/s:   %.0f\n", engineSteps / wall);
+  printf("Speed:            %.0f rpm\n", RADSToRPM(batch.omega[0]));
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  Scenario scenario;
+  if (!parseArgs(argc, argv, scenario)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Simulation sim{CylinderGeometry()};
+  sim.engineSpeed = scenario.engineSpeed;
+  sim.externalTorque = scenario.externalTorque;
+  sim.piston.throttle = scenario.throttle;
+  sim.piston.combustionAdvance = scenario.combustionAdvance;
+  sim.piston.ignitionOn = scenario.ignition;
+  sim.piston.dynamicsIsActive = scenario.dynamics;
+  sim.piston.omega = scenario.engineSpeed;
+  sim.piston.applyExtTorque(scenario.externalTorque);
+
+  if (scenario.engines > 0) {
+    return runBatch(scenario, sim.piston);
+  }
+  if (scenario.cylinders > 0) {
+    return runEngine(scenario, sim.piston);
+  }
+
+  const float deltaT = 1.f / scenario.substepRate;
+  const auto start = std::chrono::steady_clock::now();
+  if (scenario.record != nullptr) {
+    TelemetryWriter writer(scenario.record, simulationChannels(), deltaT);
+    if (!writer.isOpen()) {
+      fprintf(stderr, "Cannot write %s\n", scenario.record);
+      return 1;
+    }
+
+    const long steps = std::lround(scenario.duration / deltaT);
+    for (long i = 0; i < steps; ++i) {
+      sim.step(deltaT);
+      recordStep(writer, sim);
+    }
+    writer.close();
+
+    printf("Recorded:         %.1f MB, %llu frames dropped\n",
+           writer.getBytesWritten() / 1e6,
+           (unsigned long long)writer.getDropped());
+  } else if (scenario.session != nullptr) {
+    /* In ticks of the GUI simulation thread, a snapshot every 5 s */
+    constexpr float period = 0.02f;
+    sim.adaptive = scenario.adaptive;
+    sim.stepper.tolerance.relative = scenario.tolerance;
+    sim.substeps = std::max(std::lround(scenario.substepRate * period), 1l);
+
+    SessionRecorder recorder(sim, period, 250);
+    const long ticks = std::lround(scenario.duration / period);
+    for (long i = 0; i < ticks; ++i) {
+      sim.tick(period);
+      recorder.tick(sim);
+    }
+    if (!recorder.finish(sim).save(scenario.session)) {
+      fprintf(stderr, "Cannot write %s\n", scenario.session);
+      return 1;
+    }
+  } else if (scenario.adaptive) {
+    sim.stepper.tolerance.relative = scenario.tolerance;
+    sim.advance(scenario.duration);
+  } else {
+    sim.run(scenario.duration, deltaT);
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  const double wall = std::chrono::duration<double>(end - start).count();
+
+  const CycleReport &stats = sim.stats.report();
+  const float avgTorque = stats.last.torque;
+
+  printf("Simulated time:   %.3f s\n", sim.simTime);
+  printf("Wall time:        %.3f s\n", wall);
+  printf("Sim s / wall s:   %.1f\n", sim.simTime / wall);
+  printf("Steps/s:          %.0f\n", sim.stepCount / wall);
+  printf("Cycles:           %llu\n", (unsigned long long)sim.cycleCount);
+  if (sim.cycleCount > 0) {
+    printf("Steps/cycle:      %.0f\n", (double)sim.stepCount / sim.cycleCount);
+  }
+  if (scenario.adaptive) {
+    printf("Rejected steps:   %llu\n",
+           (unsigned long long)sim.stepper.rejected);
+  }
+  printf("Speed:            %.0f rpm\n", RADSToRPM(sim.piston.omega));
+  printf("Output torque:    %.2f Nm\n", avgTorque);
+  printf("Output power:     %.0f W\n", avgTorque * sim.piston.omega);
+  printf("Torque RMS:       %.2f Nm\n", stats.last.torqueRms);
+  printf("IMEP:             %.3f bar (COV %.2f%%)\n", stats.last.imep / 1e5,
+         100 * stats.imep.cov());
+  printf("Peak pressure:    %.2f atm at %.1f deg\n",
+         PAToATM(stats.last.peakPressure), stats.last.peakPressureAngle);
+  printf("Trapped mass:     %.2f mg\n", stats.last.trappedMass * 1e6);
+  printf("Residual O2:      %.3f\n", stats.last.residualOxygen);
+  return 0;
+}
@@ -0,0 +1,208 @@
+#include "Checkpoint.hpp"
+#include "Sweep.hpp"
+#include "WorkStealingScheduler.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/* Warms an engine up once, then forks it into one continuation per throttle
+ * and advance pair: each branch starts from the same settled state instead
+ * of paying the warm-up transient again */
+
+struct Settings {
+  double warmup = 5.0;      /* Simulated time before forking [s] */
+  double duration = 1.0;    /* Of every continuation [s] */
+  float substepRate = 1e4f; /* [Hz] */
+  float engineSpeed = 100.f;
+  float throttle = 1.f;
+  float externalTorque = 0.f;
+  bool dynamics = false;
+  SweepAxis throttleAxis = {0.f, 1.f, 5};
+  SweepAxis advanceAxis = {0.f, 0.f, 1};
+  unsigned threads = std::thread::hardware_concurrency();
+  const char *from = nullptr; /* Checkpoint to start from, no warm-up */
+  const char *save = nullptr; /* Checkpoint of the warmed up state */
+};
+
+/* Over the complete cycles of one continuation */
+struct BranchResult {
+  float torque;       /* [Nm] */
+  float imep;         /* [Pa] */
+  float peakPressure; /* [Pa] */
+  float speed;        /* At the end [rad/s] */
+  uint64_t cycles;
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "Axes take either a value or min:max:count\n"
+          "  --warmup <s>        simulated time before forking (default 5)\n"
+          "  --duration <s>      length of every branch (default 1)\n"
+          "  --rate <Hz>         substep rate (default 10000)\n"
+          "  --speed <rad/s>     set speed, initial speed with --dynamics\n"
+          "  --throttle <0..1>   throttle while warming up (default 1)\n"
+          "  --torque <Nm>       external torque (default 0)\n"
+          "  --dynamics          integrate the crankshaft speed\n"
+          "  --branch-throttle <axis>  (default 0:1:5)\n"
+          "  --branch-advance <axis>   [deg] (default 0)\n"
+          "  --threads <n>       worker threads (default: all cores)\n"
+          "  --from <file>       start from a checkpoint, skip the warm-up\n"
+          "  --save <file>       checkpoint the state the branches fork from\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Settings &s) {
+  bool ok = true;
+  for (int i = 1; ok && i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--dynamics") {
+      s.dynamics = true;
+    } else if (hasValue && arg == "--warmup") {
+      s.warmup = atof(argv[++i]);
+    } else if (hasValue && arg == "--duration") {
+      s.duration = atof(argv[++i]);
+    } else if (hasValue && arg == "--rate") {
+      s.substepRate = atof(argv[++i]);
+    } else if (hasValue && arg == "--speed") {
+      s.engineSpeed = atof(argv[++i]);
+    } else if (hasValue && arg == "--throttle") {
+      s.throttle = atof(argv[++i]);
+    } else if (hasValue && arg == "--torque") {
+      s.externalTorque = atof(argv[++i]);
+    } else if (hasValue && arg == "--branch-throttle") {
+      ok = parseAxis(argv[++i], s.throttleAxis);
+    } else if (hasValue && arg == "--branch-advance") {
+      ok = parseAxis(argv[++i], s.advanceAxis);
+    } else if (hasValue && arg == "--threads") {
+      s.threads = atoi(argv[++i]);
+    } else if (hasValue && arg == "--from") {
+      s.from = argv[++i];
+    } else if (hasValue && arg == "--save") {
+      s.save = argv[++i];
+    } else {
+      ok = false;
+    }
+  }
+  return ok && s.warmup >= 0 && s.duration > 0 && s.substepRate > 0 &&
+         s.threads > 0;
+}
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static BranchResult runBranch(const Simulation &base, float throttle,
+                              float advance, const Settings &settings) {
+  Simulation branch = base.fork();
+  branch.apply({SimCommand::Throttle, throttle});
+  branch.apply({SimCommand::CombustionAdvance, advance});
+  branch.run(settings.duration, 1.f / settings.substepRate);
+
+  /* The cycle in progress at the fork does not count */
+  constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+  const CycleReport &report = branch.stats.report();
+  const bool measured = report.torque.count > 0;
+  return BranchResult{
+      .torque = measured ? static_cast<float>(report.torque.mean) : NaN,
+      .imep = measured ? static_cast<float>(report.imep.mean) : NaN,
+      .peakPressure =
+          measured ? static_cast<float>(report.peakPressure.mean) : NaN,
+      .speed = branch.piston.omega,
+      .cycles = report.torque.count};
+}
+
+int main(int argc, char *argv[]) {
+  Settings settings;
+  if (!parseArgs(argc, argv, settings)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Simulation base{CylinderGeometry()};
+  double warmupWall = 0.0;
+  if (settings.from != nullptr) {
+    SimState state = base.save();
+    if (!readCheckpoint(settings.from, state)) {
+      fprintf(stderr, "Cannot read %s\n", settings.from);
+      return 1;
+    }
+    base.restore(state);
+  } else {
+    base.engineSpeed = settings.engineSpeed;
+    base.externalTorque = settings.externalTorque;
+    base.piston.throttle = settings.throttle;
+    base.piston.ignitionOn = true;
+    base.piston.dynamicsIsActive = settings.dynamics;
+    base.piston.omega = settings.engineSpeed;
+    base.piston.applyExtTorque(settings.externalTorque);
+
+    const auto start = std::chrono::steady_clock::now();
+    base.run(settings.warmup, 1.f / settings.substepRate);
+    warmupWall = elapsed(start);
+  }
+
+  if (settings.save != nullptr) {
+    /* A checkpoint must resume exactly where the original would go on */
+    SimState reloaded = base.save();
+    if (!writeCheckpoint(settings.save, base.save()) ||
+        !readCheckpoint(settings.save, reloaded)) {
+      fprintf(stderr, "Cannot write %s\n", settings.save);
+      return 1;
+    }
+    Simulation original = base.fork();
+    Simulation resumed{reloaded, 0};
+    original.run(0.1, 1.f / settings.substepRate);
+    resumed.run(0.1, 1.f / settings.substepRate);
+    std::vector<uint8_t> a, b;
+    saveCheckpoint(original.save(), a);
+    saveCheckpoint(resumed.save(), b);
+    if (a != b) {
+      fprintf(stderr, "Checkpoint %s does not resume exactly\n",
+              settings.save);
+      return 1;
+    }
+  }
+
+  const SweepAxis &throttles = settings.throttleAxis;
+  const SweepAxis &advances = settings.advanceAxis;
+  const size_t branches =
+      static_cast<size_t>(throttles.count) * advances.count;
+  std::vector<BranchResult> results(branches);
+
+  const auto start = std::chrono::steady_clock::now();
+  WorkStealingScheduler scheduler(settings.threads);
+  scheduler.run(branches, [&](size_t i) {
+    results[i] = runBranch(base, throttles.at(i % throttles.count),
+                           advances.at(i / throttles.count), settings);
+  });
+  const double forkWall = elapsed(start);
+
+  std::vector<uint8_t> checkpoint;
+  saveCheckpoint(base.save(), checkpoint);
+  fprintf(stderr,
+          "Forked at %.3f s, %zu byte checkpoint, warm-up %.3f s wall, "
+          "%zu branches of %.3f s in %.3f s wall\n",
+          base.simTime, checkpoint.size(), warmupWall, branches,
+          settings.duration, forkWall);
+
+  printf("throttle,advance_deg,torque_nm,imep_bar,peak_pressure_atm,"
+         "speed_rpm,cycles\n");
+  for (size_t i = 0; i < branches; ++i) {
+    const BranchResult &r = results[i];
+    printf("%g,%g,%g,%g,%g,%g,%llu\n", throttles.at(i % throttles.count),
+           advances.at(i / throttles.count), r.torque, r.imep / 1e5,
+           PAToATM(r.peakPressure), RADSToRPM(r.speed),
+           (unsigned long long)r.cycles);
+  }
+  return 0;
+}
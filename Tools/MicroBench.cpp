@@ -0,0 +1,384 @@
+#include "Logger.hpp"
+#include "Piston.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Microbenchmarks of the simulation hot path, free from the rendering and
+ * the frame pacing of the frontend. Each benchmark is calibrated to run for
+ * at least --min-time seconds per repetition; the median repetition is
+ * reported. --json writes the results in the Google Benchmark format, so
+ * runs from different builds and compilers can be compared with its tools.
+ *
+ * The gas process benchmarks replay states and inputs recorded over one
+ * cycle of a running engine, so that the arguments of exp/pow have the
+ * distribution they have in the simulation. */
+
+/* Keeps the compiler from discarding a result */
+template <typename T> inline void keep(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+constexpr float STEP = 1e-4f; /* Substep of the per step benchmarks [s] */
+
+struct Benchmark {
+  std::string name;
+  double steps; /* Simulation steps per iteration, 0 if not a step */
+  std::function<void(long iterations)> run;
+};
+
+struct Result {
+  std::string name;
+  long iterations;
+  double realTime; /* [ns] per iteration, median repetition */
+  double cpuTime;  /* [ns] per iteration, same repetition */
+  double minTime;  /* [ns] per iteration, fastest repetition */
+  double steps;
+};
+
+struct Options {
+  double minTime = 0.2; /* [s] per repetition */
+  int repetitions = 5;
+  std::string_view filter;
+  const char *json = nullptr;
+  bool list = false;
+};
+
+/* Gas state before a step and the inputs of its processes */
+struct Frame {
+  Gas gas;
+  float vprime;
+  float intakeK;
+  float exhaustK;
+  float burnK;
+  float headAngle;
+};
+
+/* One cycle at 100 rad/s, full throttle, after the first cycles settled */
+static std::vector<Frame> recordCycle() {
+  Piston piston{CylinderGeometry()};
+  piston.dynamicsIsActive = false;
+  piston.ignitionOn = true;
+  piston.throttle = 1.f;
+
+  std::vector<Frame> frames;
+  int cycles = 0;
+  while (cycles < 6) {
+    const Gas before = piston.gas;
+    piston.updatePosition(STEP, 100.f);
+    if (cycles == 5) {
+      frames.push_back({before, piston.V_prime,
+                        piston.getThrottle(piston.throttle) *
+                            piston.intakeCoef * piston.intakeValve,
+                        piston.exhaustCoef * piston.exhaustValve,
+                        piston.combustionInProgress ? piston.kexpl : 0.f,
+                        piston.headAngle});
+    }
+    if (piston.cycleTrigger) {
+      piston.cycleTrigger = false;
+      ++cycles;
+    }
+  }
+  return frames;
+}
+
+/* Applies op to the recorded frames in turn */
+template <typename Op>
+static Benchmark replay(std::string name,
+                        std::shared_ptr<const std::vector<Frame>> frames,
+                        Op op) {
+  return {std::move(name), 0, [frames, op](long iterations) {
+            const size_t n = frames->size();
+            size_t i = 0;
+            for (long k = 0; k < iterations; ++k) {
+              Frame frame = (*frames)[i];
+              op(frame);
+              keep(frame.gas);
+              i = (i + 1 == n) ? 0 : i + 1;
+            }
+          }};
+}
+
+template <typename T, typename Math>
+static Benchmark pistonStep(std::string name) {
+  return {std::move(name), 1, [](long iterations) {
+            BasicPiston<T, Math> piston{CylinderGeometry()};
+            piston.dynamicsIsActive = false;
+            piston.ignitionOn = true;
+            piston.throttle = 1.f;
+            for (long k = 0; k < iterations; ++k) {
+              piston.updatePosition(STEP, 100);
+              piston.cycleTrigger = false;
+            }
+            keep(piston.gas);
+          }};
+}
+
+/* A whole engine cycle at 100 rad/s through Simulation, logs included */
+static Benchmark cycle(float rate) {
+  const double steps = std::round(4 * std::numbers::pi / 100.0 * rate);
+  char name[64];
+  snprintf(name, sizeof(name), "Simulation/cycle/%.0fHz", rate);
+  return {name, steps, [rate](long iterations) {
+            Simulation sim{CylinderGeometry()};
+            sim.piston.dynamicsIsActive = false;
+            sim.piston.ignitionOn = true;
+            sim.piston.throttle = 1.f;
+            for (long k = 0; k < iterations; ++k) {
+              const uint64_t cycles = sim.cycleCount;
+              while (sim.cycleCount == cycles) {
+                sim.step(1.f / rate);
+              }
+            }
+            keep(sim.stats.report());
+          }};
+}
+
+static std::vector<Benchmark> benchmarks() {
+  const auto frames =
+      std::make_shared<const std::vector<Frame>>(recordCycle());
+  const float ambientP = DEFAULT_AMBIENT_PRESSURE;
+  const float ambientT = DEFAULT_AMBIENT_TEMPERATURE;
+
+  std::vector<Benchmark> list;
+  list.push_back(replay("IdealGas::AdiabaticCompress", frames, [](Frame &f) {
+    f.gas.AdiabaticCompress(f.vprime, STEP);
+  }));
+  list.push_back(replay("IdealGas::SimpleFlow", frames, [=](Frame &f) {
+    IdealGas &gas = f.gas;
+    keep(gas.SimpleFlow(f.intakeK, ambientP, ambientT, STEP));
+  }));
+  list.push_back(replay("IdealGas::HeatExchange", frames, [=](Frame &f) {
+    f.gas.HeatExchange(0.5f, ambientT, STEP);
+  }));
+  list.push_back(replay("Gas::SimpleFlow", frames, [=](Frame &f) {
+    keep(f.gas.SimpleFlow(f.exhaustK, ambientP, ambientT, 0.f, STEP));
+  }));
+  list.push_back(replay("Gas::InjectHeat", frames, [](Frame &f) {
+    keep(f.gas.InjectHeat(f.burnK, STEP));
+  }));
+
+  list.push_back({"Piston::ValveMgm", 0, [frames](long iterations) {
+                    Piston piston{CylinderGeometry()};
+                    const size_t n = frames->size();
+                    size_t i = 0;
+                    for (long k = 0; k < iterations; ++k) {
+                      piston.headAngle = (*frames)[i].headAngle;
+                      piston.ValveMgm();
+                      keep(piston.intakeValve);
+                      keep(piston.exhaustValve);
+                      i = (i + 1 == n) ? 0 : i + 1;
+                    }
+                  }});
+  list.push_back(pistonStep<float, ExactMath>("Piston::updatePosition"));
+  list.push_back(
+      pistonStep<float, FastMath>("Piston::updatePosition/FastMath"));
+  list.push_back(
+      pistonStep<double, ExactMath>("Piston::updatePosition/double"));
+
+  list.push_back({"CycleLogger::addSample", 0, [](long iterations) {
+                    CycleLogger log;
+                    float sample = 0.f;
+                    for (long k = 0; k < iterations; ++k) {
+                      /* A cycle every 2048 samples, 16 kHz at 100 rad/s */
+                      if ((k & 2047) == 2047) {
+                        log.trig();
+                      }
+                      log.addSample(sample);
+                      sample += 1.f;
+                    }
+                    keep(log.getSize());
+                  }});
+
+  list.push_back({"Simulation::step", 1, [](long iterations) {
+                    Simulation sim{CylinderGeometry()};
+                    sim.piston.dynamicsIsActive = false;
+                    sim.piston.ignitionOn = true;
+                    sim.piston.throttle = 1.f;
+                    for (long k = 0; k < iterations; ++k) {
+                      sim.step(STEP);
+                    }
+                    keep(sim.stats.report());
+                  }});
+  for (float rate : {1e4f, 1e5f, 1e6f}) {
+    list.push_back(cycle(rate));
+  }
+  return list;
+}
+
+/* Real and CPU time of one repetition [s] */
+static std::pair<double, double> time(const Benchmark &b, long iterations) {
+  const std::clock_t cpuStart = std::clock();
+  const auto start = std::chrono::steady_clock::now();
+  b.run(iterations);
+  const auto end = std::chrono::steady_clock::now();
+  const std::clock_t cpuEnd = std::clock();
+  return {std::chrono::duration<double>(end - start).count(),
+          static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC};
+}
+
+static Result measure(const Benchmark &b, const Options &options) {
+  /* Grow the iteration count until a repetition lasts long enough */
+  long iterations = 1;
+  for (;;) {
+    const double elapsed = time(b, iterations).first;
+    if (elapsed >= options.minTime || iterations >= (1L << 40)) {
+      break;
+    }
+    const double scale =
+        (elapsed > 0) ? 1.4 * options.minTime / elapsed : 100.0;
+    iterations = static_cast<long>(iterations * std::clamp(scale, 2.0, 100.0));
+  }
+
+  std::vector<std::pair<double, double>> runs;
+  for (int r = 0; r < options.repetitions; ++r) {
+    runs.push_back(time(b, iterations));
+  }
+  std::sort(runs.begin(), runs.end());
+
+  const double ns = 1e9 / iterations;
+  const auto &median = runs[runs.size() / 2];
+  return {b.name, iterations, median.first * ns, median.second * ns,
+          runs.front().first * ns, b.steps};
+}
+
+static void writeJson(FILE *out, const std::vector<Result> &results,
+                      const Options &options) {
+  char date[64];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z",
+                std::localtime(&now));
+
+#ifdef NDEBUG
+  const char *buildType = "release";
+#else
+  const char *buildType = "debug";
+#endif
+
+  fprintf(out, "{\n  \"context\": {\n");
+  fprintf(out, "    \"date\": \"%s\",\n", date);
+  fprintf(out, "    \"executable\": \"micro_bench\",\n");
+#if defined(__clang__)
+  fprintf(out, "    \"compiler\": \"clang %s\",\n", __clang_version__);
+#elif defined(__GNUC__)
+  fprintf(out, "    \"compiler\": \"gcc %s\",\n", __VERSION__);
+#endif
+  fprintf(out, "    \"library_build_type\": \"%s\",\n", buildType);
+  fprintf(out, "    \"repetitions\": %d,\n", options.repetitions);
+  fprintf(out, "    \"min_time\": %g\n  },\n", options.minTime);
+
+  fprintf(out, "  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+    fprintf(out, "      \"run_type\": \"iteration\",\n");
+    fprintf(out, "      \"iterations\": %ld,\n", r.iterations);
+    fprintf(out, "      \"real_time\": %.4f,\n", r.realTime);
+    fprintf(out, "      \"cpu_time\": %.4f,\n", r.cpuTime);
+    fprintf(out, "      \"min_time\": %.4f,\n", r.minTime);
+    if (r.steps > 0) {
+      fprintf(out, "      \"steps\": %.0f,\n", r.steps);
+      fprintf(out, "      \"ns_per_step\": %.4f,\n", r.realTime / r.steps);
+    }
+    fprintf(out, "      \"time_unit\": \"ns\"\n");
+    fprintf(out, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --filter <text>     only the benchmarks whose name contains it\n"
+          "  --min-time <s>      minimum time of a repetition (default 0.2)\n"
+          "  --repetitions <n>   repetitions, the median is kept (default 5)\n"
+          "  --json <file>       write the results as JSON, - for stdout\n"
+          "  --list              list the benchmarks and exit\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Options &o) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--list") {
+      o.list = true;
+    } else if (hasValue && arg == "--filter") {
+      o.filter = argv[++i];
+    } else if (hasValue && arg == "--min-time") {
+      o.minTime = atof(argv[++i]);
+    } else if (hasValue && arg == "--repetitions") {
+      o.repetitions = atoi(argv[++i]);
+    } else if (hasValue && arg == "--json") {
+      o.json = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return o.minTime > 0 && o.repetitions > 0;
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::vector<Benchmark> selected;
+  for (Benchmark &b : benchmarks()) {
+    if (b.name.find(options.filter) != std::string::npos) {
+      selected.push_back(std::move(b));
+    }
+  }
+  if (options.list) {
+    for (const Benchmark &b : selected) {
+      printf("%s\n", b.name.c_str());
+    }
+    return 0;
+  }
+
+  /* The table goes to stderr when the JSON goes to stdout */
+  const bool jsonToStdout =
+      options.json != nullptr && std::string_view(options.json) == "-";
+  FILE *table = jsonToStdout ? stderr : stdout;
+
+  fprintf(table, "%-36s %12s %12s %12s %12s\n", "benchmark", "ns", "cpu ns",
+          "iterations", "ns/step");
+  std::vector<Result> results;
+  for (const Benchmark &b : selected) {
+    const Result r = measure(b, options);
+    fprintf(table, "%-36s %12.2f %12.2f %12ld", r.name.c_str(), r.realTime,
+            r.cpuTime, r.iterations);
+    if (r.steps > 0) {
+      fprintf(table, " %12.2f", r.realTime / r.steps);
+    }
+    fprintf(table, "\n");
+    results.push_back(r);
+  }
+
+  if (options.json != nullptr) {
+    FILE *out = jsonToStdout ? stdout : fopen(options.json, "w");
+    if (out == nullptr) {
+      fprintf(stderr, "Cannot write %s\n", options.json);
+      return 1;
+    }
+    writeJson(out, results, options);
+    if (out != stdout) {
+      fclose(out);
+    }
+  }
+  return 0;
+}
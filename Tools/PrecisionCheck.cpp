@@ -0,0 +1,152 @@
+#include "Piston.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+/* Compares the FastMath precision policy against ExactMath: error of the
+ * approximations themselves, then cycle averaged torque, peak pressure and
+ * throughput of the whole model over a few operating points */
+
+constexpr int REPETITIONS = 5;
+
+struct Scenario {
+  float speed;    /* [rad/s] */
+  float throttle; /* [0, 1] */
+  float combustionAdvance;
+};
+
+struct Result {
+  double torque;       /* Mean over the measured cycles [Nm] */
+  double peakPressure; /* [atm] */
+  double stepsPerSecond;
+};
+
+static double relative(double x, double reference) {
+  return std::fabs(x - reference) / std::max(std::fabs(reference), 1e-30);
+}
+
+template <typename Math>
+static Result measure(const Scenario &s, float deltaT, int warmup,
+                      int cycles) {
+  BasicPiston<float, Math> piston{CylinderGeometry()};
+  piston.dynamicsIsActive = false;
+  piston.ignitionOn = true;
+  piston.throttle = s.throttle;
+  piston.combustionAdvance = s.combustionAdvance;
+  piston.omega = s.speed;
+
+  double work = 0.0;
+  double time = 0.0;
+  double peak = 0.0;
+  long steps = 0;
+  int completed = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  while (completed < warmup + cycles) {
+    piston.updatePosition(deltaT, s.speed);
+    ++steps;
+    if (completed >= warmup) {
+      work += piston.getTorque() * deltaT;
+      time += deltaT;
+      peak = std::max<double>(peak, PAToATM(piston.gas.getP()));
+    }
+    if (piston.cycleTrigger) {
+      piston.cycleTrigger = false;
+      ++completed;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  return {work / time, peak,
+          steps / std::chrono::duration<double>(end - start).count()};
+}
+
+/* Largest relative error of f against a double reference over [lo, hi] */
+template <typename F, typename R>
+static double worstError(F f, R reference, double lo, double hi, int n) {
+  double worst = 0.0;
+  for (int i = 0; i <= n; ++i) {
+    const float x = static_cast<float>(lo + (hi - lo) * i / n);
+    worst = std::max(worst, relative(f(x), reference(x)));
+  }
+  return worst;
+}
+
+static void functionErrors() {
+  const int n = 1000000;
+  const auto exactExp = [](double x) { return std::exp(x); };
+  const auto adiabatic = [](double x) { return std::pow(x, -1.4); };
+  const auto burn = [](double x) { return std::pow(0.93, x); };
+
+  printf("%-28s %12s %12s\n", "function", "ExactMath", "FastMath");
+  printf("%-28s %12.2e %12.2e\n", "exp, x in [-87, 88]",
+         worstError([](float x) { return ExactMath::exp(x); }, exactExp, -87,
+                    88, n),
+         worstError([](float x) { return FastMath::exp(x); }, exactExp, -87,
+                    88, n));
+  printf("%-28s %12.2e %12.2e\n", "pow(x, -1.4), x in [0.5, 2]",
+         worstError([](float x) { return ExactMath::pow(x, -1.4f); },
+                    adiabatic, 0.5, 2, n),
+         worstError([](float x) { return FastMath::pow(x, -1.4f); },
+                    adiabatic, 0.5, 2, n));
+  printf("%-28s %12.2e %12.2e\n", "pow(0.93, y), y in [0, 10]",
+         worstError([](float y) { return ExactMath::pow(0.93f, y); }, burn, 0,
+                    10, n),
+         worstError([](float y) { return FastMath::pow(0.93f, y); }, burn, 0,
+                    10, n));
+  printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  float rate = 1e4f;
+  int warmup = 10;
+  int cycles = 5;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (i + 1 < argc && arg == "--rate") {
+      rate = atof(argv[++i]);
+    } else if (i + 1 < argc && arg == "--warmup") {
+      warmup = atoi(argv[++i]);
+    } else if (i + 1 < argc && arg == "--cycles") {
+      cycles = atoi(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--rate <Hz>] [--warmup <n>] [--cycles <n>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  functionErrors();
+
+  const Scenario scenarios[] = {{100.f, 1.f, 0.f},  {100.f, 0.2f, 0.f},
+                                {300.f, 1.f, 10.f}, {300.f, 0.5f, 10.f},
+                                {600.f, 1.f, 20.f}, {600.f, 0.2f, 20.f}};
+
+  printf("%6s %5s %5s | %10s %10s %9s | %9s %9s | %8s\n", "speed", "thr",
+         "adv", "torque", "fast", "rel err", "p peak", "rel err", "speedup");
+  for (const Scenario &s : scenarios) {
+    /* A run takes milliseconds: the best of a few, alternated, for the
+     * throughput */
+    Result exact = measure<ExactMath>(s, 1.f / rate, warmup, cycles);
+    Result fast = measure<FastMath>(s, 1.f / rate, warmup, cycles);
+    for (int i = 1; i < REPETITIONS; ++i) {
+      exact.stepsPerSecond =
+          std::max(exact.stepsPerSecond,
+                   measure<ExactMath>(s, 1.f / rate, warmup, cycles)
+                       .stepsPerSecond);
+      fast.stepsPerSecond = std::max(
+          fast.stepsPerSecond,
+          measure<FastMath>(s, 1.f / rate, warmup, cycles).stepsPerSecond);
+    }
+    printf("%6.0f %5.2f %5.1f | %10.4f %10.4f %9.2e | %9.3f %9.2e | %7.2fx\n",
+           s.speed, s.throttle, s.combustionAdvance, exact.torque, fast.torque,
+           relative(fast.torque, exact.torque), exact.peakPressure,
+           relative(fast.peakPressure, exact.peakPressure),
+           fast.stepsPerSecond / exact.stepsPerSecond);
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+#include "Session.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+/* Plays a recorded session back headless. The final state must match the
+ * recorded one bit for bit; --verify checks every snapshot on the way too,
+ * --seek jumps to a point through the nearest snapshot. */
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static void printState(const Simulation &sim) {
+  const CycleSummary &last = sim.stats.report().last;
+  printf("  Simulated time:   %.3f s (tick %llu)\n", sim.simTime,
+         (unsigned long long)sim.tickCount);
+  printf("  Speed:            %.0f rpm\n", RADSToRPM(sim.piston.omega));
+  printf("  Head angle:       %.2f deg\n", sim.piston.headAngle);
+  printf("  Pressure:         %.3f atm\n", PAToATM(sim.piston.gas.getP()));
+  printf("  Output torque:    %.2f Nm\n", last.torque);
+  printf("  Digest:           %016llx\n",
+         (unsigned long long)stateDigest(sim.save()));
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = nullptr;
+  double seekTime = -1.0;
+  bool verify = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--verify") {
+      verify = true;
+    } else if (i + 1 < argc && arg == "--seek") {
+      seekTime = atof(argv[++i]);
+    } else if (path == nullptr && arg[0] != '-') {
+      path = argv[i];
+    } else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (path == nullptr) {
+    fprintf(stderr, "Usage: %s <session> [--seek <s>] [--verify]\n", argv[0]);
+    return 1;
+  }
+
+  Session session;
+  if (!session.load(path)) {
+    fprintf(stderr, "Cannot read %s\n", path);
+    return 1;
+  }
+
+  const uint64_t ticks = session.endTick - session.startTick();
+  printf("Session:          %.3f s, %llu ticks of %.1f ms\n",
+         ticks * session.period, (unsigned long long)ticks,
+         session.period * 1e3f);
+  printf("Events:           %zu\n", session.events.size());
+  printf("Snapshots:        %zu, every %llu ticks\n", session.snapshots.size(),
+         (unsigned long long)session.snapshotInterval);
+
+  Simulation sim{session.snapshots.front()};
+  SessionPlayer player(session, sim);
+
+  if (seekTime >= 0) {
+    const uint64_t target =
+        session.startTick() + std::llround(seekTime / session.period);
+    const auto start = std::chrono::steady_clock::now();
+    player.seek(target);
+    printf("Seek to %.3f s:   %.1f ms\n", seekTime, elapsed(start) * 1e3);
+    printState(sim);
+    if (!verify) {
+      return 0;
+    }
+
+    /* The same tick reached by playing from the start */
+    const uint64_t digest = stateDigest(sim.save());
+    player.seek(session.startTick());
+    while (player.position() < target && player.step()) {
+    }
+    const bool match = stateDigest(sim.save()) == digest;
+    printf("Linear playback:  %s\n", match ? "match" : "MISMATCH");
+    return match ? 0 : 1;
+  }
+
+  /* Every snapshot is where playback passes by, in tick order */
+  size_t snapshot = 1;
+  size_t diverged = 0;
+  const auto start = std::chrono::steady_clock::now();
+  while (player.step()) {
+    if (verify && snapshot < session.snapshots.size() &&
+        session.snapshots[snapshot].tickCount == player.position()) {
+      if (stateDigest(session.snapshots[snapshot]) !=
+          stateDigest(sim.save())) {
+        if (diverged++ == 0) {
+          printf("First divergence: %.3f s\n", sim.simTime);
+        }
+      }
+      ++snapshot;
+    }
+  }
+  const double wall = elapsed(start);
+
+  printf("Playback:         %.3f s, %.1f sim s / wall s\n", wall,
+         ticks * session.period / wall);
+  if (verify) {
+    printf("Snapshots:        %zu of %zu diverged\n", diverged,
+           session.snapshots.size() - 1);
+  }
+  printf("Final state:\n");
+  printState(sim);
+
+  const bool match = stateDigest(sim.save()) == session.digest;
+  printf("Recorded final:   %s\n", match ? "match" : "MISMATCH");
+  return (match && diverged == 0) ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "Piston.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+/* Runs the same operating points with a float and a double piston: steps/s
+ * of each, then how far the float cycle metrics drift from the double ones
+ * as the cycles accumulate */
+
+struct Scenario {
+  float speed;    /* [rad/s], initial speed with dynamics */
+  float throttle; /* [0, 1] */
+  float combustionAdvance;
+  float externalTorque; /* [Nm] */
+  bool dynamics;
+};
+
+/* One complete cycle, accumulated in double for both scalar types */
+struct CycleMetrics {
+  double torque;       /* Mean [Nm] */
+  double peakPressure; /* [Pa] */
+  double trappedMass;  /* At the cycle end [kg] */
+  double oxygen;       /* Residual at the cycle end [0, 1] */
+  double duration;     /* [s] */
+};
+
+struct Run {
+  std::vector<CycleMetrics> cycles;
+  double stepsPerSecond;
+};
+
+template <typename T>
+static Run measure(const Scenario &s, T deltaT, int warmup, int cycles) {
+  BasicPiston<T> piston{CylinderGeometry()};
+  piston.dynamicsIsActive = s.dynamics;
+  piston.ignitionOn = true;
+  piston.throttle = s.throttle;
+  piston.combustionAdvance = s.combustionAdvance;
+  piston.omega = s.speed;
+  piston.applyExtTorque(s.externalTorque);
+
+  Run run;
+  run.cycles.reserve(cycles);
+  CycleMetrics current{};
+  long steps = 0;
+  int completed = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  while (completed < warmup + cycles) {
+    piston.updatePosition(deltaT, s.speed);
+    ++steps;
+    current.torque += piston.getTorque() * deltaT;
+    current.duration += deltaT;
+    current.peakPressure =
+        std::max<double>(current.peakPressure, piston.gas.getP());
+
+    if (piston.cycleTrigger) {
+      piston.cycleTrigger = false;
+      if (completed++ >= warmup) {
+        current.torque /= current.duration;
+        current.trappedMass = NRToKG(piston.gas.getnR());
+        current.oxygen = piston.gas.getOx();
+        run.cycles.push_back(current);
+      }
+      current = {};
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  run.stepsPerSecond =
+      steps / std::chrono::duration<double>(end - start).count();
+  return run;
+}
+
+static double relative(double x, double reference) {
+  return std::fabs(x - reference) / std::max(std::fabs(reference), 1e-30);
+}
+
+static void compare(const Scenario &s, float rate, int warmup, int cycles) {
+  const Run single = measure<float>(s, 1.f / rate, warmup, cycles);
+  const Run reference = measure<double>(s, 1.0 / rate, warmup, cycles);
+
+  printf("%.0f rad/s, throttle %.2f, advance %.1f, torque %.1f Nm%s\n",
+         s.speed, s.throttle, s.combustionAdvance, s.externalTorque,
+         s.dynamics ? ", dynamics" : "");
+  printf("  steps/s: float %.2fM, double %.2fM, float is %.2fx\n",
+         single.stepsPerSecond / 1e6, reference.stepsPerSecond / 1e6,
+         single.stepsPerSecond / reference.stepsPerSecond);
+  printf("  %7s | %10s %9s %9s | %9s %9s %9s %9s\n", "cycle", "torque",
+         "rel err", "mean err", "p peak", "mass", "O2", "duration");
+
+  /* Worst relative error of single cycles up to each checkpoint, decades
+   * and the last cycle, and error of the torque averaged since the start */
+  CycleMetrics worst{};
+  double singleWork = 0.0, singleTime = 0.0;
+  double referenceWork = 0.0, referenceTime = 0.0;
+  int checkpoint = 1;
+  for (int i = 0; i < cycles; ++i) {
+    const CycleMetrics &f = single.cycles[i];
+    const CycleMetrics &d = reference.cycles[i];
+    singleWork += f.torque * f.duration;
+    singleTime += f.duration;
+    referenceWork += d.torque * d.duration;
+    referenceTime += d.duration;
+    worst.torque = std::max(worst.torque, relative(f.torque, d.torque));
+    worst.peakPressure = std::max(worst.peakPressure,
+                                  relative(f.peakPressure, d.peakPressure));
+    worst.trappedMass =
+        std::max(worst.trappedMass, relative(f.trappedMass, d.trappedMass));
+    worst.oxygen = std::max(worst.oxygen, relative(f.oxygen, d.oxygen));
+    worst.duration =
+        std::max(worst.duration, relative(f.duration, d.duration));
+
+    if (i + 1 == checkpoint || i + 1 == cycles) {
+      printf("  %7d | %10.4f %9.2e %9.2e | %9.2e %9.2e %9.2e %9.2e\n",
+             i + 1, d.torque, worst.torque,
+             relative(singleWork / singleTime, referenceWork / referenceTime),
+             worst.peakPressure, worst.trappedMass, worst.oxygen,
+             worst.duration);
+      checkpoint *= 10;
+    }
+  }
+  printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+  float rate = 1e4f;
+  int warmup = 0;
+  int cycles = 1000;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (i + 1 < argc && arg == "--rate") {
+      rate = atof(argv[++i]);
+    } else if (i + 1 < argc && arg == "--warmup") {
+      warmup = atoi(argv[++i]);
+    } else if (i + 1 < argc && arg == "--cycles") {
+      cycles = atoi(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--rate <Hz>] [--warmup <n>] [--cycles <n>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (rate <= 0 || warmup < 0 || cycles <= 0) {
+    fprintf(stderr, "Invalid arguments\n");
+    return 1;
+  }
+
+  printf("Relative errors of float against double, worst up to the cycle\n\n");
+
+  const Scenario scenarios[] = {{100.f, 1.f, 0.f, 0.f, false},
+                                {300.f, 0.5f, 10.f, 0.f, false},
+                                {600.f, 0.2f, 20.f, 0.f, false},
+                                {300.f, 1.f, 10.f, -2.f, true}};
+  for (const Scenario &s : scenarios) {
+    compare(s, rate, warmup, cycles);
+  }
+  return 0;
+}
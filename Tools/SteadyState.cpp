@@ -0,0 +1,201 @@
+#include "Simulation.hpp"
+#include "SteadyState.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+/* Runs one operating point until its cycles settle and reports the
+ * converged cycle. With --aitken it also runs plain iteration to compare the
+ * time to answer, with --reference the distance to a long plain run. */
+
+struct Settings {
+  float substepRate = 1e4f; /* [Hz] */
+  float engineSpeed = 100.f;
+  float throttle = 1.f;
+  float externalTorque = 0.f;
+  bool dynamics = false;
+  SteadyStateSettings steady;
+  bool compare = false;
+  int reference = 0; /* Cycles of plain iteration to check against */
+  bool verbose = false;
+};
+
+struct Solution {
+  SteadyStateReport report;
+  CycleSummary cycle; /* Converged cycle */
+  float speed;        /* At its end [rad/s] */
+  double simTime;     /* [s] */
+  double wall;        /* [s] */
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --rate <Hz>         substep rate (default 10000)\n"
+          "  --speed <rad/s>     set speed, initial speed with --dynamics\n"
+          "  --throttle <0..1>   throttle position (default 1)\n"
+          "  --torque <Nm>       external torque (default 0)\n"
+          "  --dynamics          integrate the crankshaft speed\n"
+          "  --tolerance <r>     relative distance to the periodic state, as\n"
+          "                      bounded (default 2e-3)\n"
+          "  --max-cycles <n>    give up after (default 100)\n"
+          "  --aitken            extrapolate, compare with plain iteration\n"
+          "  --reference <n>     distance to the state after n plain cycles\n"
+          "  --verbose           residual of every cycle\n",
+          prog);
+}
+
+static bool parseArgs(int argc, char *argv[], Settings &s) {
+  bool ok = true;
+  for (int i = 1; ok && i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--dynamics") {
+      s.dynamics = true;
+    } else if (arg == "--aitken") {
+      s.steady.acceleration = Acceleration::Aitken;
+      s.compare = true;
+    } else if (hasValue && arg == "--reference") {
+      s.reference = atoi(argv[++i]);
+    } else if (arg == "--verbose") {
+      s.verbose = true;
+    } else if (hasValue && arg == "--rate") {
+      s.substepRate = atof(argv[++i]);
+    } else if (hasValue && arg == "--speed") {
+      s.engineSpeed = atof(argv[++i]);
+    } else if (hasValue && arg == "--throttle") {
+      s.throttle = atof(argv[++i]);
+    } else if (hasValue && arg == "--torque") {
+      s.externalTorque = atof(argv[++i]);
+    } else if (hasValue && arg == "--tolerance") {
+      s.steady.tolerance = atof(argv[++i]);
+    } else if (hasValue && arg == "--max-cycles") {
+      s.steady.maxCycles = atoi(argv[++i]);
+    } else {
+      ok = false;
+    }
+  }
+  return ok && s.substepRate > 0 && s.engineSpeed > 0 &&
+         s.steady.tolerance > 0 && s.steady.maxCycles > 0;
+}
+
+static Solution solve(const Settings &settings,
+                      const SteadyStateSettings &steady) {
+  const auto start = std::chrono::steady_clock::now();
+
+  Simulation sim{CylinderGeometry()};
+  sim.engineSpeed = settings.engineSpeed;
+  sim.externalTorque = settings.externalTorque;
+  sim.piston.throttle = settings.throttle;
+  sim.piston.ignitionOn = true;
+  sim.piston.dynamicsIsActive = settings.dynamics;
+  sim.piston.omega = settings.engineSpeed;
+
+  SteadyStateTracker tracker(steady);
+
+  /* A stalling engine never ends its cycle, the speed may halve */
+  const float deltaT = 1.f / settings.substepRate;
+  const double maxTime = (steady.maxCycles + 2) * 8 * std::numbers::pi /
+                         settings.engineSpeed;
+  while (tracker.report().status == SteadyStatus::Running &&
+         sim.simTime < maxTime) {
+    sim.step(deltaT);
+    tracker.update(sim.piston);
+  }
+
+  const std::chrono::duration<double> wall =
+      std::chrono::steady_clock::now() - start;
+  return Solution{.report = tracker.report(),
+                  .cycle = sim.stats.report().last,
+                  .speed = sim.piston.omega,
+                  .simTime = sim.simTime,
+                  .wall = wall.count()};
+}
+
+static const char *statusName(SteadyStatus status) {
+  switch (status) {
+  case SteadyStatus::Running:
+    return "stalled";
+  case SteadyStatus::Converged:
+    return "converged";
+  case SteadyStatus::Failed:
+    return "not converged";
+  }
+  return "";
+}
+
+static const char *accelerationName(Acceleration acceleration) {
+  switch (acceleration) {
+  case Acceleration::None:
+    return "Plain";
+  case Acceleration::Aitken:
+    return "Aitken";
+  }
+  return "";
+}
+
+static void print(const char *name, const Solution &s, bool verbose) {
+  const SteadyStateReport &r = s.report;
+  const float *x = r.state.values;
+  printf("%s: %s after %d cycles, %d extrapolated, residual %.2e\n", name,
+         statusName(r.status), r.cycles, r.extrapolations, r.residual);
+  printf("  error bound %.2e, contraction %.3f per cycle\n", r.errorBound,
+         r.contraction);
+  printf("  simulated %.3f s in %.4f s wall\n", s.simTime, s.wall);
+  printf("  section: %.2f rpm, %.4f mg, %.1f K, oxygen %.4f\n",
+         RADSToRPM(x[0]), NRToKG(x[1]) * 1e6f, x[2], x[3]);
+  printf("  last cycle: torque %.3f Nm, IMEP %.3f bar, peak %.2f atm, "
+         "trapped %.2f mg\n",
+         s.cycle.torque, s.cycle.imep / 1e5, PAToATM(s.cycle.peakPressure),
+         s.cycle.trappedMass * 1e6);
+  if (verbose) {
+    for (size_t i = 0; i < r.residuals.size(); ++i) {
+      printf("  cycle %3zu  residual %.3e  bound %.3e\n", i + 1,
+             r.residuals[i], r.errorBounds[i]);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Settings settings;
+  if (!parseArgs(argc, argv, settings)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  const Solution solution = solve(settings, settings.steady);
+  print(accelerationName(settings.steady.acceleration), solution,
+        settings.verbose);
+
+  Solution plain;
+  if (settings.compare) {
+    SteadyStateSettings steady = settings.steady;
+    steady.acceleration = Acceleration::None;
+    plain = solve(settings, steady);
+    print("Plain", plain, settings.verbose);
+    printf("Speed-up: %.1fx in cycles, %.1fx in wall time\n",
+           static_cast<double>(plain.report.cycles) /
+               std::max(solution.report.cycles, 1),
+           plain.wall / solution.wall);
+  }
+
+  /* Long enough, plain iteration is the ground truth */
+  if (settings.reference > 0) {
+    SteadyStateSettings steady = settings.steady;
+    steady.acceleration = Acceleration::None;
+    steady.tolerance = 0.f;
+    steady.maxCycles = settings.reference;
+    const CycleState truth = solve(settings, steady).report.state;
+    printf("Distance to the state after %d plain cycles: %.2e",
+           settings.reference,
+           CycleState::distance(solution.report.state, truth));
+    if (settings.compare) {
+      printf(", plain %.2e", CycleState::distance(plain.report.state, truth));
+    }
+    printf("\n");
+  }
+  return solution.report.status == SteadyStatus::Converged ? 0 : 2;
+}
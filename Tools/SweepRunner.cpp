@@ -0,0 +1,142 @@
+#include "CycleCache.hpp"
+#include "Sweep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+
+/* Builds engine maps over a grid of operating points, on all cores */
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "Axes take either a value or min:max:count\n"
+          "  --throttle <axis>   throttle position (default 0:1:11)\n"
+          "  --speed <axis>      set speed [rad/s] (default 100)\n"
+          "  --advance <axis>    combustion advance [deg] (default 0)\n"
+          "  --kexpl <axis>      combustion K (default 0.07)\n"
+          "  --warmup <n>        cycles before measuring (default 10)\n"
+          "  --until-steady      end the warm-up once the cycles settle,\n"
+          "                      --warmup cycles at most\n"
+          "  --tolerance <r>     of --until-steady, relative distance to the\n"
+          "                      steady cycle as bounded (default 2e-3)\n"
+          "  --cycles <n>        measured cycles (default 2)\n"
+          "  --rate <Hz>         substep rate (default 10000)\n"
+          "  --adaptive          error controlled steps instead of --rate\n"
+          "  --threads <n>       worker threads (default: all cores)\n"
+          "  --cache <file>      reuse the points of earlier runs, and keep\n"
+          "                      the new ones, in a memory mapped store\n"
+          "  --repeat <n>        run the sweep n times, the later runs from\n"
+          "                      the in-memory cache (default 1)\n"
+          "  --out <file>        CSV output (default stdout)\n",
+          prog);
+}
+
+int main(int argc, char *argv[]) {
+  SweepGrid grid = {.throttle = {0.f, 1.f, 11},
+                    .speed = {100.f, 100.f, 1},
+                    .combustionAdvance = {0.f, 0.f, 1},
+                    .kexpl = {0.07f, 0.07f, 1}};
+  SweepSettings settings;
+  unsigned threads = std::thread::hardware_concurrency();
+  const char *outPath = nullptr;
+  const char *cachePath = nullptr;
+  int repeat = 1;
+
+  bool ok = true;
+  for (int i = 1; ok && i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--until-steady") {
+      settings.untilSteady = true;
+    } else if (arg == "--adaptive") {
+      settings.adaptive = true;
+    } else if (i + 1 >= argc) {
+      ok = false;
+    } else if (arg == "--throttle") {
+      ok = parseAxis(argv[++i], grid.throttle);
+    } else if (arg == "--speed") {
+      ok = parseAxis(argv[++i], grid.speed);
+    } else if (arg == "--advance") {
+      ok = parseAxis(argv[++i], grid.combustionAdvance);
+    } else if (arg == "--kexpl") {
+      ok = parseAxis(argv[++i], grid.kexpl);
+    } else if (arg == "--warmup") {
+      settings.warmupCycles = atoi(argv[++i]);
+    } else if (arg == "--tolerance") {
+      settings.steadyTolerance = atof(argv[++i]);
+    } else if (arg == "--cycles") {
+      settings.measuredCycles = atoi(argv[++i]);
+    } else if (arg == "--rate") {
+      settings.substepRate = atof(argv[++i]);
+    } else if (arg == "--threads") {
+      threads = atoi(argv[++i]);
+    } else if (arg == "--out") {
+      outPath = argv[++i];
+    } else if (arg == "--cache") {
+      cachePath = argv[++i];
+    } else if (arg == "--repeat") {
+      repeat = atoi(argv[++i]);
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || settings.warmupCycles < 0 || settings.measuredCycles <= 0 ||
+      settings.substepRate <= 0 || settings.steadyTolerance <= 0 ||
+      repeat <= 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror(outPath);
+    return 1;
+  }
+
+  /* Without a store and with a single run there is nothing to reuse */
+  CycleCache cache(std::max<size_t>(grid.size(), 1024));
+  const bool cached = cachePath != nullptr || repeat > 1;
+  if (cachePath != nullptr && !cache.openStore(cachePath)) {
+    fprintf(stderr, "Cannot open the cache %s\n", cachePath);
+    return 1;
+  }
+
+  std::vector<CycleResult> results;
+  for (int run = 0; run < repeat; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+    results = runSweep(CylinderGeometry(), grid, settings, threads,
+                       cached ? &cache : nullptr);
+    const auto end = std::chrono::steady_clock::now();
+
+    const double wall = std::chrono::duration<double>(end - start).count();
+    fprintf(stderr, "%zu points in %.2f s (%.1f points/s, %u threads)\n",
+            grid.size(), wall, grid.size() / wall, threads > 0 ? threads : 1);
+  }
+  if (settings.untilSteady && !results.empty()) {
+    double warmup = 0.0;
+    for (const CycleResult &r : results) {
+      warmup += r.warmupCycles;
+    }
+    warmup /= results.size();
+    const int fixed = settings.warmupCycles + settings.measuredCycles;
+    fprintf(stderr,
+            "Warm-up: %.1f of %d cycles on average, %.1fx fewer cycles "
+            "per point\n",
+            warmup, settings.warmupCycles,
+            fixed / (warmup + settings.measuredCycles));
+  }
+  if (cached) {
+    fprintf(stderr, "Cache: %llu hits (%llu from the store), %llu misses\n",
+            (unsigned long long)cache.hits,
+            (unsigned long long)cache.storeHits,
+            (unsigned long long)cache.misses);
+  }
+
+  writeTable(out, grid, results);
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "TelemetryReader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <string_view>
+
+/* Summarizes a telemetry file, or exports a range of it as CSV */
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s <file> [options]\n"
+          "  --csv               print the samples instead of a summary\n"
+          "  --from <sample>     first sample (default 0)\n"
+          "  --count <n>         number of samples (default all)\n",
+          prog);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  bool csv = false;
+  uint64_t first = 0;
+  uint64_t count = UINT64_MAX;
+  for (int i = 2; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+
+    if (arg == "--csv") {
+      csv = true;
+    } else if (hasValue && arg == "--from") {
+      first = strtoull(argv[++i], nullptr, 10);
+    } else if (hasValue && arg == "--count") {
+      count = strtoull(argv[++i], nullptr, 10);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  TelemetryReader reader(argv[1]);
+  if (!reader.isOpen()) {
+    fprintf(stderr, "Cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  std::vector<std::vector<float>> columns(reader.getChannelCount());
+  for (int c = 0; c < reader.getChannelCount(); ++c) {
+    reader.read(c, first, count, columns[c]);
+  }
+  const size_t samples = columns[0].size();
+
+  if (csv) {
+    printf("time");
+    for (int c = 0; c < reader.getChannelCount(); ++c) {
+      printf(",%s", reader.getChannelName(c).c_str());
+    }
+    printf("\n");
+    for (size_t i = 0; i < samples; ++i) {
+      printf("%.6f", (first + i + 1) * (double)reader.getDeltaT());
+      for (const std::vector<float> &column : columns) {
+        printf(",%g", column[i]);
+      }
+      printf("\n");
+    }
+    return 0;
+  }
+
+  const double raw = static_cast<double>(reader.getSampleCount()) *
+                     reader.getChannelCount() * sizeof(float);
+  printf("Samples:          %llu\n",
+         (unsigned long long)reader.getSampleCount());
+  printf("Duration:         %.3f s\n",
+         reader.getSampleCount() * (double)reader.getDeltaT());
+  printf("File size:        %.2f MB (%.2fx smaller than raw)\n",
+         reader.getFileSize() / 1e6, raw / reader.getFileSize());
+  printf("%-12s %12s %12s %12s\n", "channel", "min", "mean", "max");
+  for (int c = 0; c < reader.getChannelCount(); ++c) {
+    const std::vector<float> &v = columns[c];
+    if (v.empty()) {
+      continue;
+    }
+    const auto [lo, hi] = std::minmax_element(v.begin(), v.end());
+    const double mean = std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+    printf("%-12s %12.4g %12.4g %12.4g\n", reader.getChannelName(c).c_str(),
+           *lo, mean, *hi);
+  }
+  return 0;
+}
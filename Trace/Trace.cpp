@@ -0,0 +1,120 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Buffers outlive their threads, so a trace can be written after a join */
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> registry;
+
+TraceBuffer &Trace::buffer() {
+  thread_local TraceBuffer *local = [] {
+    std::lock_guard lock(registryMutex);
+    const int id = static_cast<int>(registry.size()) + 1;
+    registry.push_back(std::make_unique<TraceBuffer>(id));
+    return registry.back().get();
+  }();
+  return *local;
+}
+
+void Trace::setThreadName(const char *name) {
+  buffer().threadName.store(name, std::memory_order_relaxed);
+}
+
+void Trace::counter(const char *name, double value) {
+  buffer().push({name, now(), 0, value, TraceEvent::Counter});
+}
+
+/* Consistent copy of the events still held by a buffer */
+static std::vector<TraceEvent> collect(const TraceBuffer &buffer) {
+  const uint64_t end = buffer.written.load(std::memory_order_acquire);
+  const uint64_t begin =
+      (end > TraceBuffer::CAPACITY) ? end - TraceBuffer::CAPACITY : 0;
+
+  std::vector<TraceEvent> events;
+  events.reserve(end - begin);
+  for (uint64_t i = begin; i < end; ++i) {
+    events.push_back(buffer.events[i & (TraceBuffer::CAPACITY - 1)]);
+  }
+
+  /* Slots reused by the owner during the copy may be torn: the events
+   * published since, and the one it may be writing, event after, which is
+   * published only once complete */
+  const uint64_t after = buffer.written.load(std::memory_order_acquire);
+  if (after >= begin + TraceBuffer::CAPACITY) {
+    const uint64_t torn =
+        std::min<uint64_t>(after + 1 - begin - TraceBuffer::CAPACITY,
+                           events.size());
+    events.erase(events.begin(), events.begin() + torn);
+  }
+  return events;
+}
+
+bool Trace::writeChrome(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == nullptr) {
+    return false;
+  }
+
+  struct Thread {
+    int id;
+    const char *name;
+    std::vector<TraceEvent> events;
+  };
+  std::vector<Thread> threads;
+  {
+    std::lock_guard lock(registryMutex);
+    for (const auto &buffer : registry) {
+      threads.push_back({buffer->id,
+                         buffer->threadName.load(std::memory_order_relaxed),
+                         collect(*buffer)});
+    }
+  }
+
+  /* Timestamps relative to the oldest event, in microseconds */
+  uint64_t origin = UINT64_MAX;
+  for (const Thread &thread : threads) {
+    for (const TraceEvent &event : thread.events) {
+      origin = std::min(origin, event.start);
+    }
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  const auto separator = [&] {
+    if (!first) {
+      fprintf(file, ",\n");
+    }
+    first = false;
+  };
+
+  for (const Thread &thread : threads) {
+    if (thread.name != nullptr) {
+      separator();
+      fprintf(file,
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+              "\"args\":{\"name\":\"%s\"}}",
+              thread.id, thread.name);
+    }
+    for (const TraceEvent &event : thread.events) {
+      const double ts = (event.start - origin) / 1e3;
+      separator();
+      if (event.type == TraceEvent::Zone) {
+        fprintf(file,
+                "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%.3f,\"dur\":%.3f}",
+                event.name, thread.id, ts, event.duration / 1e3);
+      } else {
+        fprintf(file,
+                "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%.3f,\"args\":{\"value\":%g}}",
+                event.name, thread.id, ts, event.value);
+      }
+    }
+  }
+  fprintf(file, "\n]}\n");
+
+  return fclose(file) == 0;
+}
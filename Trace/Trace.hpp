@@ -0,0 +1,111 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/* Hot path instrumentation: scoped zones and counters recorded into per
+ * thread buffers, exported on demand as Chrome trace JSON, readable by
+ * chrome://tracing and ui.perfetto.dev. Configure with -DENGINE_TRACE=ON to
+ * record; otherwise the TRACE_ macros expand to nothing and their arguments
+ * are not evaluated. Names must be string literals.
+ *
+ *   TRACE_SCOPE(name)        zone until the end of the scope
+ *   TRACE_ZONE(zone, name)   zone until TRACE_END(zone) or the scope end
+ *   TRACE_COUNTER(name, v)   sample of a counter track
+ *   TRACE_THREAD(name)       name of the calling thread in the trace */
+
+struct TraceEvent {
+  enum Type : uint32_t { Zone, Counter };
+
+  const char *name;
+  uint64_t start;    /* [ns] on the steady clock */
+  uint64_t duration; /* Zone [ns] */
+  double value;      /* Counter */
+  Type type;
+};
+
+/* Last CAPACITY events of one thread. Only the owner thread writes, without
+ * locks; the exporter copies the window and then drops the events the owner
+ * may have overwritten during the copy. */
+class TraceBuffer {
+public:
+  static constexpr uint64_t CAPACITY = 1 << 16;
+
+  explicit TraceBuffer(int id) : id{id} {}
+
+  void push(const TraceEvent &event) {
+    const uint64_t n = written.load(std::memory_order_relaxed);
+    events[n & (CAPACITY - 1)] = event;
+    written.store(n + 1, std::memory_order_release);
+  }
+
+  const int id;
+  std::atomic<const char *> threadName{nullptr};
+  std::atomic<uint64_t> written{0};
+  TraceEvent events[CAPACITY];
+};
+
+class Trace {
+public:
+#ifdef ENGINE_TRACE
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /* Buffer of the calling thread, registered on first use */
+  static TraceBuffer &buffer();
+
+  static void setThreadName(const char *name);
+  static void counter(const char *name, double value);
+
+  /* Events of all the threads so far; false if the file cannot be written */
+  static bool writeChrome(const char *path);
+};
+
+/* Records the lifetime of the enclosing scope, or until end() */
+class TraceZone {
+public:
+  explicit TraceZone(const char *name) : name{name}, start{Trace::now()} {}
+  ~TraceZone() { end(); }
+
+  void end() {
+    if (name != nullptr) {
+      Trace::buffer().push({name, start, Trace::now() - start, 0.0,
+                            TraceEvent::Zone});
+      name = nullptr;
+    }
+  }
+
+  TraceZone(const TraceZone &) = delete;
+  TraceZone &operator=(const TraceZone &) = delete;
+
+private:
+  const char *name;
+  uint64_t start;
+};
+
+#ifdef ENGINE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_ZONE(zone, name) TraceZone zone(name)
+#define TRACE_END(zone) zone.end()
+#define TRACE_COUNTER(name, value) Trace::counter(name, value)
+#define TRACE_THREAD(name) Trace::setThreadName(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_ZONE(zone, name) ((void)0)
+#define TRACE_END(zone) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
+#endif
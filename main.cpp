@@ -1,28 +1,130 @@
+#include "AudioOutput.hpp"
+#include "Decimator.hpp"
+#include "FramePacer.hpp"
 #include "FrameRVis.hpp"
 #include "Game.hpp"
 #include "Logger.hpp"
-#include "Piston.hpp"
 #include "PistonGraphics.hpp"
+#include "SimThread.hpp"
+#include "Simulation.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
-#include <numeric>
+
+using FrameClock = std::chrono::steady_clock;
 
 int SIMULATION_MULTIPLIER = 200;
 float FRAMETIME = 20.f; /* ms */
+/* Simulation tick [ms]. With sound an input waits at most one tick to be
+ * stepped, then behind the audio queue: short ticks keep the whole path
+ * under 20 ms, see audio_render */
+float TICKTIME = FRAMETIME;
+constexpr float AUDIO_TICKTIME = 5.f;
 float pistonX = 350.f;
 float pistonY = 550.f;
-float engineSpeed = 100.f;
 
-float externalTorque = 0.f;
+/* UI side copy of the inputs, edits are forwarded to the simulation thread */
+struct Controls {
+  bool dynamicsIsActive;
+  bool ignitionOn;
+  bool adaptive;
+  bool meanValue; /* Engine map instead of the detailed model */
+  bool governed;  /* Substeps follow the machine */
+  float targetLoad;
+  float externalTorque;
+  float throttle;
+  float engineSpeed;
+  float kexpl;
+  float combustionAdvance;
+  float thermalK;
+  float intakeCoef;
+  float exhaustCoef;
+  float minThrottle;
+};
+
+/* Decimated cycle traces, one per plotted channel */
+struct CyclePlots {
+  DecimatedSeries torque{Decimation::MinMax};
+  DecimatedSeries oxygen{Decimation::Lttb};
+  DecimatedSeries pressure{Decimation::MinMax};
+  DecimatedSeries temperature{Decimation::Lttb};
+  DecimatedSeries intake{Decimation::Lttb};
+  DecimatedSeries exhaust{Decimation::Lttb};
+};
+
+/* The last two published piston states. The display shows the state of one
+ * tick ago, interpolated between them by the wall time they were published
+ * at, so that it moves at the frame rate rather than in tick sized jumps
+ * that beat against it. A longer lag falls before previous and holds it,
+ * a shorter one runs past latest. */
+struct PistonHistory {
+  Piston previous;
+  Piston latest;
+  double previousTime; /* Simulated [s] */
+  double latestTime;
+  FrameClock::time_point previousWall; /* Published */
+  FrameClock::time_point latestWall;
+
+  void update(const SimSnapshot &snap) {
+    if (snap.published == latestWall) {
+      return;
+    }
+    previous = latest;
+    previousTime = latestTime;
+    previousWall = latestWall;
+    latest = snap.piston;
+    latestTime = snap.simTime;
+    latestWall = snap.published;
+  }
 
-float average(std::vector<float> const &v) {
-  if (v.empty()) {
-    return 0;
+  Piston at(FrameClock::time_point wall) const {
+    const float span =
+        std::chrono::duration<float>(latestWall - previousWall).count();
+    const float elapsed =
+        std::chrono::duration<float>(wall - previousWall).count();
+    const float alpha = (span > 0) ? std::clamp(elapsed / span, 0.f, 1.f) : 1;
+    return interpolatePiston(previous, latest, latestTime - previousTime,
+                             alpha);
+  }
+};
+
+/* Keyboard bindings for the inputs changed most while calibrating, they
+ * move the controls like the sliders do. Returns whether key is bound. */
+bool keyCommand(SDL_Keycode key, Controls &controls, SimCommand &command) {
+  constexpr float THROTTLE_STEP = 0.05f;
+  constexpr float TORQUE_STEP = 1.f; /* [Nm] */
+
+  switch (key) {
+  case SDLK_UP:
+  case SDLK_DOWN:
+    controls.throttle += (key == SDLK_UP) ? THROTTLE_STEP : -THROTTLE_STEP;
+    controls.throttle = std::clamp(controls.throttle, 0.f, 1.f);
+    command = {SimCommand::Throttle, controls.throttle};
+    return true;
+  case SDLK_LEFT:
+  case SDLK_RIGHT:
+    /* Right for more load, the range of the slider */
+    controls.externalTorque += (key == SDLK_LEFT) ? TORQUE_STEP : -TORQUE_STEP;
+    controls.externalTorque = std::clamp(controls.externalTorque, -20.f, 0.f);
+    command = {SimCommand::ExternalTorque, controls.externalTorque};
+    return true;
+  default:
+    return false;
   }
+}
+
+/* Two points per horizontal pixel of the next plot, enough for min/max */
+int plotBudget() {
+  return std::max(2 * static_cast<int>(ImGui::GetContentRegionAvail().x), 16);
+}
 
-  auto const count = static_cast<float>(v.size());
-  return std::reduce(v.begin(), v.end()) / count;
+void plotSeries(const char *label, DecimatedSeries &series,
+                std::span<const float> data, uint64_t cycle, int points) {
+  series.update(data, cycle, points);
+  ImPlot::PlotLine(label, series.getX(), series.getY(), series.getSize());
 }
 
 int main(int argc, char *argv[]) {
@@ -34,14 +136,56 @@ int main(int argc, char *argv[]) {
   FrameRVis *fVis = new FrameRVis();
   FrameRVis *load = new FrameRVis();
   CylinderGeometry *geom = new CylinderGeometry();
-  Piston *piston = new Piston(*geom);
-  CycleLogger *pistonPosLogger = new CycleLogger();
-  CycleLogger *pressureLogger = new CycleLogger();
-  CycleLogger *intakeLog = new CycleLogger();
-  CycleLogger *exhaustLog = new CycleLogger();
-  CycleLogger *torqueLog = new CycleLogger();
-  CycleLogger *tempLog = new CycleLogger();
-  CycleLogger *oxyLog = new CycleLogger();
+  Simulation *sim = new Simulation(*geom);
+
+  /* Engine sound, fed by the simulation thread after every step, which then
+   * ticks at the same step rate on the shorter tick */
+  AudioOutput *audio = new AudioOutput();
+  EngineSound *sound = audio->open() ? audio->getSound() : nullptr;
+  if (sound != nullptr) {
+    sim->onStep = [sim, sound](float deltaT) {
+      sound->push(sim->piston, deltaT);
+    };
+    TICKTIME = AUDIO_TICKTIME;
+    SIMULATION_MULTIPLIER = std::max<int>(
+        std::lround(SIMULATION_MULTIPLIER * TICKTIME / FRAMETIME), 1);
+  }
+  SimThread *simThread =
+      new SimThread(*sim, TICKTIME / 1000.f, SIMULATION_MULTIPLIER);
+
+  Controls controls = {.dynamicsIsActive = sim->piston.dynamicsIsActive,
+                       .ignitionOn = sim->piston.ignitionOn,
+                       .adaptive = sim->adaptive,
+                       .meanValue = sim->meanValue,
+                       .governed = true,
+                       .targetLoad = 0.5f,
+                       .externalTorque = sim->externalTorque,
+                       .throttle = sim->piston.throttle,
+                       .engineSpeed = sim->engineSpeed,
+                       .kexpl = sim->piston.kexpl,
+                       .combustionAdvance = sim->piston.combustionAdvance,
+                       .thermalK = sim->piston.thermalK,
+                       .intakeCoef = sim->piston.intakeCoef,
+                       .exhaustCoef = sim->piston.exhaustCoef,
+                       .minThrottle = sim->piston.minThrottle};
+
+  /* Persistent across frames, pointed at the latest snapshot every frame:
+   * the frame loop allocates nothing once the plots have their size */
+  CyclePlots plots;
+  PistonHistory history{.previous = sim->piston,
+                        .latest = sim->piston,
+                        .previousTime = sim->simTime,
+                        .latestTime = sim->simTime,
+                        .previousWall = {},
+                        .latestWall = {}};
+  Piston shownPiston = sim->piston;
+  PistonGraphics pistonGraphics(vector2_T{.x = pistonX, .y = pistonY},
+                                &shownPiston, 2000);
+  FramePacer framePacer;
+  const auto framePeriod = std::chrono::duration_cast<FrameClock::duration>(
+      std::chrono::duration<float, std::milli>(FRAMETIME));
+  const auto tickPeriod = std::chrono::duration_cast<FrameClock::duration>(
+      std::chrono::duration<float, std::milli>(TICKTIME));
 
   printf("Game initialized\n");
 
@@ -53,132 +197,257 @@ int main(int argc, char *argv[]) {
   ImGui_ImplSDL2_InitForSDLRenderer(game->window, game->renderer);
   ImGui_ImplSDLRenderer2_Init(game->renderer);
 
+  /* Newest input event of the frame: the UI edits of the frame answer it,
+   * the simulation measures its latency from there */
+  FrameClock::time_point inputTime = FrameClock::now();
+  auto send = [&](SimCommand command) { simThread->send(command, inputTime); };
+
+  game->onEvent = [&](const SDL_Event &event) {
+    switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+      break;
+    default:
+      return;
+    }
+    /* SDL stamps events in milliseconds of SDL_GetTicks() */
+    const auto age =
+        std::chrono::milliseconds(SDL_GetTicks() - event.common.timestamp);
+    inputTime = FrameClock::now() - age;
+
+    SimCommand command;
+    if (event.type == SDL_KEYDOWN && !io.WantCaptureKeyboard &&
+        keyCommand(event.key.keysym.sym, controls, command)) {
+      send(command);
+    }
+  };
+
+  /* From here on the simulation belongs to its thread */
+  simThread->setTargetLoad(controls.targetLoad);
+  simThread->start();
+
   printf("Start the game loop\n");
+  TRACE_THREAD("render");
 
   /* Game Loop */
+  auto nextFrame = FrameClock::now();
   while (game->isGameRunning()) {
+    TRACE_SCOPE("frame");
     fVis->startClock();
     load->startClock();
-    const int timeStart = SDL_GetTicks();
-    PistonGraphics *pistonGraphics =
-        new PistonGraphics(vector2_T{.x = pistonX, .y = pistonY}, piston, 2000);
-
-    /* Simulation */
-    for (size_t i = 0; i < SIMULATION_MULTIPLIER; ++i) {
-      piston->updatePosition(FRAMETIME / (1000.f * SIMULATION_MULTIPLIER),
-                             engineSpeed);
-
-      piston->applyExtTorque(externalTorque);
-
-      /* Log Data */
-      pistonPosLogger->addSample(piston->getPistonPosition());
-      pressureLogger->addSample(PAToATM(piston->gas->getP()));
-      intakeLog->addSample(piston->intakeFlow);
-      exhaustLog->addSample(piston->exhaustFlow);
-      torqueLog->addSample(piston->getTorque());
-      tempLog->addSample(KELVToCELS(piston->gas->getT()));
-      oxyLog->addSample(piston->gas->getOx());
-
-      if (piston->cycleTrigger) {
-        pistonPosLogger->trig();
-        pressureLogger->trig();
-        intakeLog->trig();
-        exhaustLog->trig();
-        torqueLog->trig();
-        tempLog->trig();
-        oxyLog->trig();
-        piston->cycleTrigger = false;
-      }
-    }
 
-    const float avgTorque = average(torqueLog->getV());
+    /* Inputs first, they reach the simulation at its next tick */
+    TRACE_ZONE(eventsZone, "events");
+    inputTime = FrameClock::now();
+    game->handleEvents();
+    TRACE_END(eventsZone);
+
+    /* Latest published simulation state */
+    const SimSnapshot &snap = simThread->snapshot();
+    history.update(snap);
+    shownPiston = history.at(FrameClock::now() - tickPeriod);
+
+    const CycleSummary &cycleStats = snap.stats.last;
+    const float avgTorque = cycleStats.torque;
 
+    TRACE_ZONE(uiZone, "ImGui build");
     ImGui_ImplSDLRenderer2_NewFrame();
     ImGui_ImplSDL2_NewFrame();
     ImGui::NewFrame();
 
     ImGui::Begin("Test");
     ImGui::Text("Framerate: %.1f fps", fVis->getFramerate());
-    ImGui::Text("Speed: %.0f rpm", RADSToRPM(piston->omega));
+    ImGui::Text("Speed: %.0f rpm", RADSToRPM(snap.piston.omega));
     ImGui::Text("Load:      %.2f", 100.f * load->getLast() / FRAMETIME);
-    ImGui::Text("Simul:     %.0f Hz",
-                fVis->getFramerate() * SIMULATION_MULTIPLIER);
+    ImGui::Text("Sim load:  %.2f", 100.f * snap.load);
+    const char *rateNote = snap.governed ? " (auto)" : "";
+    if (snap.atFloor) {
+      rateNote = " (accuracy floor)";
+    }
+    ImGui::Text("Simul:     %.0f Hz%s", snap.substepRate, rateNote);
+    if (snap.logOverflow) {
+      ImGui::Text("Cycle longer than the logs: traces truncated");
+    }
 
-    ImGui::Text("Output torque: %.0f Nm", avgTorque);
-    ImGui::Text("Output power:  %.0f W", avgTorque * piston->omega);
+    /* The mean-value model has no cycle to show, the last detailed one
+     * stays in the plots */
+    if (snap.meanValue && !snap.meanValueMap) {
+      ImGui::Text("Building the engine map, detailed model until then");
+    } else if (snap.meanValue) {
+      const MeanValuePoint &mv = snap.meanValuePoint;
+      ImGui::Text("Mean-value torque: %.1f Nm", mv.torque);
+      ImGui::Text("Mean-value power:  %.0f W", mv.torque * snap.piston.omega);
+      ImGui::Text("Airflow:           %.2f g/s", mv.airflow * 1e3f);
+      ImGui::Text("Exhaust:           %.0f K", mv.exhaustTemperature);
+    }
 
-    ImGui::Checkbox("Activate dynamics", &piston->dynamicsIsActive);
-    ImGui::Checkbox("Ignition", &piston->ignitionOn);
-    ImGui::SliderFloat("Torque", &externalTorque, -20.f, 0.f);
-    ImGui::SliderFloat("Throttle", &piston->throttle, 0.f, 1.f);
+    ImGui::Text("Output torque: %.0f Nm", avgTorque);
+    ImGui::Text("Output power:  %.0f W", avgTorque * snap.piston.omega);
+    ImGui::Text("Torque RMS:    %.1f Nm", cycleStats.torqueRms);
+    ImGui::Text("IMEP:          %.2f bar (COV %.1f%%)", cycleStats.imep / 1e5,
+                100 * snap.stats.imep.cov());
+    ImGui::Text("Peak pressure: %.1f atm at %.0f°",
+                PAToATM(cycleStats.peakPressure), cycleStats.peakPressureAngle);
+    ImGui::Text("Trapped mass:  %.1f mg", cycleStats.trappedMass * 1e6);
+    ImGui::Text("Residual O2:   %.2f", cycleStats.residualOxygen);
+
+    if (ImGui::Checkbox("Activate dynamics", &controls.dynamicsIsActive)) {
+      send({SimCommand::Dynamics, controls.dynamicsIsActive ? 1.f : 0.f});
+    }
+    if (ImGui::Checkbox("Ignition", &controls.ignitionOn)) {
+      send({SimCommand::Ignition, controls.ignitionOn ? 1.f : 0.f});
+    }
+    if (ImGui::SliderFloat("Torque", &controls.externalTorque, -20.f, 0.f)) {
+      send({SimCommand::ExternalTorque, controls.externalTorque});
+    }
+    if (ImGui::SliderFloat("Throttle", &controls.throttle, 0.f, 1.f)) {
+      send({SimCommand::Throttle, controls.throttle});
+    }
+    if (ImGui::Checkbox("Mean-value model", &controls.meanValue)) {
+      send({SimCommand::MeanValue, controls.meanValue ? 1.f : 0.f});
+    }
+    if (ImGui::Checkbox("Adaptive step", &controls.adaptive)) {
+      send({SimCommand::Adaptive, controls.adaptive ? 1.f : 0.f});
+    }
+    if (!controls.adaptive &&
+        ImGui::Checkbox("Auto substeps", &controls.governed)) {
+      /* Manual control starts from the rate the governor left */
+      SIMULATION_MULTIPLIER =
+          std::lround(snap.substepRate * TICKTIME / 1000.f);
+      simThread->setTargetLoad(controls.governed ? controls.targetLoad : 0.f);
+    }
+    if (!controls.adaptive && controls.governed &&
+        ImGui::SliderFloat("Target load", &controls.targetLoad, 0.1f, 0.9f)) {
+      simThread->setTargetLoad(controls.targetLoad);
+    }
+    if (!controls.adaptive && !controls.governed &&
+        ImGui::SliderInt("Substeps", &SIMULATION_MULTIPLIER, 10, 2000)) {
+      simThread->setSubsteps(SIMULATION_MULTIPLIER);
+    }
+    bool recording = simThread->isRecording();
+    if (ImGui::Checkbox("Record session", &recording)) {
+      if (recording) {
+        simThread->startRecording("engine_session.essn");
+      } else {
+        simThread->stopRecording();
+      }
+    }
+    if (sound != nullptr) {
+      float volume = sound->volume.load();
+      if (ImGui::SliderFloat("Volume", &volume, 0.f, 1.f)) {
+        sound->volume.store(volume);
+      }
+      ImGui::Text("Audio latency: %.1f ms, underruns %llu",
+                  sound->getLatency() * 1e3f,
+                  (unsigned long long)sound->getUnderruns());
+    }
+    ImGui::Text("Input latency: %.1f ms, max %.1f ms (event to tick)",
+                snap.inputLatency * 1e3f, snap.maxInputLatency * 1e3f);
+    ImGui::Text("Keys: Up/Down throttle, Left/Right load");
+    if (Trace::enabled && ImGui::Button("Save trace")) {
+      Trace::writeChrome("engine_trace.json");
+    }
     ImGui::End();
 
     ImGui::Begin("Test2");
-    ImGui::InputFloat("Engine speed", &engineSpeed, 0, 0, "%.0f", 0);
-    ImGui::InputFloat("Combustion K", &piston->kexpl, 0, 0, "%.4f", 0);
-    ImGui::InputFloat("Combustion Advance °", &piston->combustionAdvance, 0, 0,
-                      "%.2f", 0);
-    ImGui::InputFloat("Thermal K", &piston->thermalK, 0, 0, "%.4f", 0);
-    ImGui::InputFloat("Intake K", &piston->intakeCoef, 0, 0, "%.4f", 0);
-    ImGui::InputFloat("Exhaust K", &piston->exhaustCoef, 0, 0, "%.4f", 0);
-    ImGui::InputFloat("Min Throttle", &piston->minThrottle, 0, 0, "%.4f", 0);
+    if (ImGui::InputFloat("Engine speed", &controls.engineSpeed, 0, 0, "%.0f",
+                          0)) {
+      send({SimCommand::EngineSpeed, controls.engineSpeed});
+    }
+    if (ImGui::InputFloat("Combustion K", &controls.kexpl, 0, 0, "%.4f", 0)) {
+      send({SimCommand::CombustionK, controls.kexpl});
+    }
+    if (ImGui::InputFloat("Combustion Advance °", &controls.combustionAdvance,
+                          0, 0, "%.2f", 0)) {
+      send({SimCommand::CombustionAdvance, controls.combustionAdvance});
+    }
+    if (ImGui::InputFloat("Thermal K", &controls.thermalK, 0, 0, "%.4f", 0)) {
+      send({SimCommand::ThermalK, controls.thermalK});
+    }
+    if (ImGui::InputFloat("Intake K", &controls.intakeCoef, 0, 0, "%.4f", 0)) {
+      send({SimCommand::IntakeK, controls.intakeCoef});
+    }
+    if (ImGui::InputFloat("Exhaust K", &controls.exhaustCoef, 0, 0, "%.4f",
+                          0)) {
+      send({SimCommand::ExhaustK, controls.exhaustCoef});
+    }
+    if (ImGui::InputFloat("Min Throttle", &controls.minThrottle, 0, 0, "%.4f",
+                          0)) {
+      send({SimCommand::MinThrottle, controls.minThrottle});
+    }
     ImGui::End();
 
+    const CycleTraces &cycle = snap.cycle;
+    const uint64_t cycleId = snap.cycleCount;
+    int points;
+
     ImGui::Begin("Test3");
+    points = plotBudget();
     ImPlot::SetNextAxesToFit();
     ImPlot::BeginPlot("ASD");
-    ImPlot::PlotLine("Torque", torqueLog->getData(),
-                     std::min(torqueLog->getSize(), 15000));
-    ImPlot::PlotLine("Oxy", oxyLog->getData(),
-                     std::min(oxyLog->getSize(), 15000));
+    plotSeries("Torque", plots.torque, cycle.torque, cycleId, points);
+    plotSeries("Oxy", plots.oxygen, cycle.oxygen, cycleId, points);
     ImPlot::EndPlot();
     ImGui::End();
 
     ImGui::Begin("Test4");
+    points = plotBudget();
     ImPlot::SetNextAxesToFit();
     ImPlot::BeginPlot("ASD");
-    ImPlot::PlotLine("Pressure", pressureLogger->getData(),
-                     std::min(pressureLogger->getSize(), 15000));
+    plotSeries("Pressure", plots.pressure, cycle.pressure, cycleId, points);
     ImPlot::EndPlot();
     ImGui::End();
 
     ImGui::Begin("Test5");
+    points = plotBudget();
     ImPlot::SetNextAxesToFit();
     ImPlot::BeginPlot("ASD");
-    ImPlot::PlotLine("Temperature", tempLog->getData(),
-                     std::min(tempLog->getSize(), 15000));
+    plotSeries("Temperature", plots.temperature, cycle.temperature, cycleId,
+               points);
     ImPlot::EndPlot();
     ImGui::End();
 
     ImGui::Begin("Test6");
+    points = plotBudget();
     ImPlot::SetNextAxesToFit();
     ImPlot::BeginPlot("ASD");
-    ImPlot::PlotLine("Intake", intakeLog->getData(),
-                     std::min(intakeLog->getSize(), 15000));
-    ImPlot::PlotLine("Exhaust", exhaustLog->getData(),
-                     std::min(exhaustLog->getSize(), 15000));
+    plotSeries("Intake", plots.intake, cycle.intake, cycleId, points);
+    plotSeries("Exhaust", plots.exhaust, cycle.exhaust, cycleId, points);
     ImPlot::EndPlot();
     ImGui::End();
 
     /* Rendering */
     ImGui::Render();
+    TRACE_END(uiZone);
 
-    game->handleEvents();
     game->RenderClear();
+    TRACE_ZONE(pistonZone, "showPiston");
+    pistonGraphics.showPiston(game->renderer);
+    TRACE_END(pistonZone);
 
-    pistonGraphics->showPiston(game->renderer);
+    /* Present as soon as drawn, waiting comes after */
+    TRACE_ZONE(presentZone, "present");
+    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData());
+    game->RenderPresent();
+    TRACE_END(presentZone);
 
     load->endClock();
+    TRACE_COUNTER("frame load", load->getLast() / FRAMETIME);
 
-    /* Wait for next frame */
-    int delay = FRAMETIME - (SDL_GetTicks() - timeStart);
-    SDL_Delay((delay > 0) ? delay : 0);
-
-    ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData());
-    game->RenderPresent();
+    /* Wait for next frame, late frames do not make the next ones short */
+    TRACE_ZONE(waitZone, "wait");
+    nextFrame = std::max(nextFrame + framePeriod, FrameClock::now());
+    framePacer.waitUntil(nextFrame);
+    TRACE_END(waitZone);
     fVis->endClock();
   }
 
+  simThread->stop();
+  audio->close();
+
   ImGui_ImplSDLRenderer2_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImPlot::DestroyContext();